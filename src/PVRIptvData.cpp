@@ -26,25 +26,47 @@
 
 #include "client.h"
 #include "iptvsimple/Settings.h"
+#include "iptvsimple/utilities/FileUtils.h"
 #include "iptvsimple/utilities/Logger.h"
+#include "iptvsimple/utilities/MemoryUtils.h"
+#include "iptvsimple/utilities/Metrics.h"
+#include "iptvsimple/utilities/Tracer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
 
 using namespace ADDON;
 using namespace iptvsimple;
 using namespace iptvsimple::data;
 using namespace iptvsimple::utilities;
 
+// std::min() and the std::chrono constructors take these by reference so they need a definition
+const int PVRIptvData::SETTINGS_RELOAD_DELAY_MS;
+const int PVRIptvData::REFRESH_RETRY_MIN_SECS;
+const int PVRIptvData::REFRESH_RETRY_MAX_SECS;
+const int PVRIptvData::REFRESH_JITTER_PERCENT;
+
 PVRIptvData::PVRIptvData()
 {
+  Metrics::GetInstance().SetEnabled(Settings::GetInstance().CollectMetrics());
+
   m_channels.Clear();
   m_channelGroups.Clear();
   m_epg.Clear();
 
-  m_playlistLoader.LoadPlayList();
+  // Channels from the last run are available straight away, the playlist is revalidated in the update thread
+  m_playlistLoadedFromSnapshot = m_playlistLoader.LoadPlayListSnapshot();
+  PublishChannelStreamProperties();
 }
 
 bool PVRIptvData::Start()
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  TimedLockObject lock(m_mutex);
 
   XBMC->Log(LOG_INFO, "%s Starting separate client update thread...", __FUNCTION__);
   CreateThread();
@@ -54,19 +76,136 @@ bool PVRIptvData::Start()
 
 void* PVRIptvData::Process()
 {
-  while (!IsStopped())
+  // Load the playlist here rather than in the constructor so ADDON_Create is not blocked
+  // by the download, channels are published to Kodi in batches as they are parsed.
+  // If the channels came from the snapshot only the differences are published instead.
+  // The XMLTV and genres are fetched on their own threads while the playlist loads here.
+  // Only binding the EPG to the channels has to wait for both.
+  Tracer::GetInstance().SetThreadName("PVRIptvData::Process");
+  std::unique_ptr<ScopedTraceSpan> startupSpan(new ScopedTraceSpan("PVRIptvData::Process startup"));
+
   {
-    Sleep(PROCESS_LOOP_WAIT_SECS * 1000);
+    TimedLockObject lock(m_mutex);
+    m_epg.SetFetchInProgress(true);
+  }
 
-    P8PLATFORM::CLockObject lock(m_mutex);
-    if (m_reloadChannelsGroupsAndEPG)
-    {
-      Sleep(1000);
+  std::future<std::unique_ptr<XmltvDocument>> xmltvFuture = std::async(std::launch::async, [this]()
+  {
+    Tracer::GetInstance().SetThreadName("XMLTV fetch");
+    return m_epg.FetchXMLTV();
+  });
+  std::future<std::vector<EpgGenre>> genresFuture = std::async(std::launch::async, []()
+  {
+    Tracer::GetInstance().SetThreadName("Genres fetch");
+    std::vector<EpgGenre> genres;
+    Epg::LoadGenres(genres);
+    return genres;
+  });
+
+  // The EPG is bound after the playlist has loaded so any change to its channels is already covered
+  bool epgChannelsChanged = false;
+  const bool playlistLoaded = m_playlistLoadedFromSnapshot ? m_playlistLoader.ReloadPlayList(epgChannelsChanged) : m_playlistLoader.LoadPlayList();
+  m_playlistRefreshFailures = playlistLoaded ? 0 : 1;
+
+  PublishChannelStreamProperties();
 
-      m_playlistLoader.ReloadPlayList();
-      m_epg.ReloadEPG();
+  std::vector<EpgGenre> genres = genresFuture.get();
+  const std::unique_ptr<XmltvDocument> xmltvDocument = xmltvFuture.get();
+  {
+    TimedLockObject lock(m_mutex);
+    m_epg.SetGenres(std::move(genres));
+    if (!xmltvDocument)
+      m_epg.SetFetchInProgress(false);
+  }
 
-      m_reloadChannelsGroupsAndEPG = false;
+  // The EPG is built without the lock, BindEPG() only takes it to publish the result and clear the fetch in progress
+  const bool epgBound = xmltvDocument && m_epg.BindEPG(*xmltvDocument, m_mutex);
+
+  if (epgBound)
+    m_epg.TriggerEpgUpdates();
+
+  ReportMemoryUsage("startup");
+
+  // Startup is what the trace is mostly for so it is written now rather than only when the addon stops
+  startupSpan.reset();
+  if (Tracer::IsEnabled())
+    Tracer::GetInstance().WriteFile(FileUtils::GetUserFilePath(TRACE_FILE_NAME));
+
+  m_startupLoadComplete = true;
+
+  ScheduleRefresh(UpdateJob::RELOAD_PLAYLIST, Settings::GetInstance().GetM3URefreshIntervalMins(), m_playlistRefreshFailures);
+  ScheduleRefresh(UpdateJob::REFRESH_EPG, Settings::GetInstance().GetEpgRefreshIntervalMins(), m_epgRefreshFailures);
+
+  // Sleeps until a job is due, there is nothing to do between jobs
+  UpdateJob job;
+  while (!IsStopped() && m_updateScheduler.WaitForDueJob(job))
+  {
+    switch (job)
+    {
+      case UpdateJob::RELOAD_PLAYLIST:
+      {
+        // On failure the current channels stay published until a later attempt succeeds
+        bool epgChannelsChanged = false;
+        if (m_playlistLoader.ReloadPlayList(epgChannelsChanged))
+        {
+          m_playlistRefreshFailures = 0;
+          PublishChannelStreamProperties();
+
+          if (epgChannelsChanged)
+          {
+            // Added channels, or ones matched to the XMLTV differently, have no EPG until it is
+            // bound to the channels again. The refresh also applies the logos taken from the EPG.
+            m_updateScheduler.ScheduleNoLaterThan(UpdateJob::REFRESH_EPG, std::chrono::milliseconds(0));
+          }
+          else
+          {
+            // The same XMLTV channels are matched so only the logos taken from the EPG need applying
+            TimedLockObject lock(m_mutex);
+            if (Settings::GetInstance().GetEpgLogosMode() != EpgLogosMode::IGNORE_XMLTV)
+              m_epg.ApplyChannelsLogosFromEPG();
+          }
+        }
+        else
+        {
+          m_playlistRefreshFailures++;
+        }
+        ReportMemoryUsage("playlist reload");
+        ScheduleRefresh(UpdateJob::RELOAD_PLAYLIST, Settings::GetInstance().GetM3URefreshIntervalMins(), m_playlistRefreshFailures);
+        break;
+      }
+      case UpdateJob::RELOAD_EPG:
+        m_epg.ReloadEPG(m_mutex);
+        ReportMemoryUsage("EPG reload");
+        break;
+      case UpdateJob::REFRESH_EPG:
+        if (m_epg.RefreshEPG(m_mutex))
+          m_epgRefreshFailures = 0;
+        else
+          m_epgRefreshFailures++;
+        ReportMemoryUsage("EPG refresh");
+        ScheduleRefresh(UpdateJob::REFRESH_EPG, Settings::GetInstance().GetEpgRefreshIntervalMins(), m_epgRefreshFailures);
+        {
+          // Scheduling the next refresh replaces any due one, so a window Kodi asked for during this refresh is loaded now
+          TimedLockObject lock(m_mutex);
+          if (m_epg.RefreshPending())
+            m_updateScheduler.ScheduleNoLaterThan(UpdateJob::REFRESH_EPG, std::chrono::milliseconds(0));
+        }
+        break;
+      case UpdateJob::APPLY_EPG_TIMESHIFT:
+      {
+        TimedLockObject lock(m_mutex);
+        m_epg.ApplyTimeshiftSettings();
+        break;
+      }
+      case UpdateJob::APPLY_CHANNEL_LOGOS:
+      {
+        TimedLockObject lock(m_mutex);
+        m_channels.ApplyChannelLogos();
+        if (Settings::GetInstance().GetEpgLogosMode() != EpgLogosMode::IGNORE_XMLTV)
+          m_epg.ApplyChannelsLogosFromEPG();
+        PVR->TriggerChannelUpdate();
+        break;
+      }
     }
   }
 
@@ -75,10 +214,13 @@ void* PVRIptvData::Process()
 
 PVRIptvData::~PVRIptvData()
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  // The update thread takes the lock to publish channels so it must not be held while stopping it
   Logger::Log(LEVEL_DEBUG, "%s Stopping update thread...", __FUNCTION__);
+  m_fetchCancellationToken.Cancel();
+  m_updateScheduler.Stop();
   StopThread();
 
+  TimedLockObject lock(m_mutex);
   m_channels.Clear();
   m_channelGroups.Clear();
   m_epg.Clear();
@@ -86,21 +228,23 @@ PVRIptvData::~PVRIptvData()
 
 int PVRIptvData::GetChannelsAmount()
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  TimedLockObject lock(m_mutex);
   return m_channels.GetChannelsAmount();
 }
 
 PVR_ERROR PVRIptvData::GetChannels(ADDON_HANDLE handle, bool bRadio)
 {
-  std::vector<PVR_CHANNEL> channels;
+  ScopedMetricTimer callTimer(MetricTimer::GET_CHANNELS);
+
+  std::shared_ptr<const std::vector<PVR_CHANNEL>> channels;
   {
-    P8PLATFORM::CLockObject lock(m_mutex);
-    m_channels.GetChannels(channels, bRadio);
+    TimedLockObject lock(m_mutex);
+    channels = m_channels.GetKodiChannels(bRadio);
   }
 
-  Logger::Log(LEVEL_DEBUG, "%s - channels available '%d', radio = %d", __FUNCTION__, channels.size(), bRadio);
+  Logger::Log(LEVEL_DEBUG, "%s - channels available '%d', radio = %d", __FUNCTION__, channels->size(), bRadio);
 
-  for (auto& channel : channels)
+  for (const auto& channel : *channels)
     PVR->TransferChannelEntry(handle, &channel);
 
   return PVR_ERROR_NO_ERROR;
@@ -108,28 +252,133 @@ PVR_ERROR PVRIptvData::GetChannels(ADDON_HANDLE handle, bool bRadio)
 
 bool PVRIptvData::GetChannel(const PVR_CHANNEL& channel, Channel& myChannel)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  TimedLockObject lock(m_mutex);
 
   return m_channels.GetChannel(channel, myChannel);
 }
 
+void PVRIptvData::ScheduleRefresh(UpdateJob job, int intervalMins, int failures)
+{
+  int delaySecs = intervalMins * 60;
+
+  // After a failure try again sooner, backing off exponentially but never waiting longer than a normal refresh
+  if (failures > 0)
+  {
+    const int maxDelaySecs = delaySecs > 0 ? std::min(delaySecs, REFRESH_RETRY_MAX_SECS) : REFRESH_RETRY_MAX_SECS;
+    delaySecs = std::min(REFRESH_RETRY_MIN_SECS << std::min(failures - 1, 16), maxDelaySecs);
+  }
+
+  if (delaySecs <= 0)
+  {
+    m_updateScheduler.Cancel(job);
+    return;
+  }
+
+  // Jitter so many clients started together don't all hit the provider at the same time
+  const int jitterMs = delaySecs * 10 * REFRESH_JITTER_PERCENT;
+  std::uniform_int_distribution<int> jitterDistribution(-jitterMs, jitterMs);
+  int delayMs;
+  {
+    TimedLockObject lock(m_mutex);
+    delayMs = delaySecs * 1000 + jitterDistribution(m_randomGenerator);
+  }
+
+  m_updateScheduler.Schedule(job, std::chrono::milliseconds(delayMs));
+}
+
+void PVRIptvData::PublishChannelStreamProperties()
+{
+  TimedLockObject lock(m_mutex);
+
+  const auto channelStreamProperties = std::atomic_load(&m_channelStreamProperties);
+  if (!channelStreamProperties || channelStreamProperties->channelsGeneration != m_channels.GetGeneration())
+    std::atomic_store(&m_channelStreamProperties, m_channels.CreateStreamProperties());
+}
+
+void PVRIptvData::ReportMemoryUsage(const char* phase)
+{
+  // Walking every channel and EPG entry is only worth it when someone is looking
+  if (!Metrics::IsEnabled())
+    return;
+
+  TimedLockObject lock(m_mutex);
+
+  const uint64_t channelsBytes = m_channels.GetMemoryUsage();
+  const uint64_t channelGroupsBytes = m_channelGroups.GetMemoryUsage();
+  const uint64_t epgBytes = m_epg.GetMemoryUsage();
+  Metrics::Set(MetricGauge::CHANNELS_BYTES, channelsBytes);
+  Metrics::Set(MetricGauge::CHANNEL_GROUPS_BYTES, channelGroupsBytes);
+  Metrics::Set(MetricGauge::EPG_BYTES, epgBytes);
+
+  // The high water mark only grows so the growth since the last report is what this phase added to the peak
+  const uint64_t previousPeakRss = Metrics::Get(MetricGauge::PEAK_RSS_BYTES);
+  const uint64_t peakRss = MemoryUtils::GetPeakResidentSetSize();
+  Metrics::Set(MetricGauge::PEAK_RSS_BYTES, peakRss);
+
+  Logger::Log(LEVEL_NOTICE, "%s - Memory after %s: channels %" PRIu64 " KB, channel groups %" PRIu64 " KB, EPG %" PRIu64 " KB, peak RSS %" PRIu64 " KB (+%" PRIu64 " KB)",
+              __FUNCTION__, phase, channelsBytes / 1024, channelGroupsBytes / 1024, epgBytes / 1024, peakRss / 1024,
+              peakRss > previousPeakRss ? (peakRss - previousPeakRss) / 1024 : 0);
+}
+
+PVR_ERROR PVRIptvData::GetChannelStreamProperties(const PVR_CHANNEL& channel, PVR_NAMED_VALUE* properties, unsigned int* iPropertiesCount)
+{
+  ScopedMetricTimer callTimer(MetricTimer::GET_CHANNEL_STREAM_PROPERTIES);
+
+  const auto channelStreamProperties = std::atomic_load(&m_channelStreamProperties);
+  auto streamPropertiesPair = channelStreamProperties->streamPropertiesByUniqueId.find(channel.iUniqueId);
+
+  // Channels published while the playlist is still loading may not be in the last published properties yet.
+  // Only that channel is copied here, the whole map is republished by the update thread once the load completes.
+  ChannelStreamProperties::StreamProperties loadingChannelStreamProperties;
+  const ChannelStreamProperties::StreamProperties* streamProperties = &loadingChannelStreamProperties;
+  if (streamPropertiesPair != channelStreamProperties->streamPropertiesByUniqueId.end())
+  {
+    streamProperties = &streamPropertiesPair->second;
+  }
+  else
+  {
+    TimedLockObject lock(m_mutex);
+    if (!m_channels.GetChannelStreamProperties(channel.iUniqueId, loadingChannelStreamProperties))
+      return PVR_ERROR_SERVER_ERROR;
+  }
+
+  const unsigned int maxPropertiesCount = *iPropertiesCount;
+  *iPropertiesCount = 0;
+
+  for (const auto& prop : *streamProperties)
+  {
+    if (*iPropertiesCount >= maxPropertiesCount)
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Not enough room for all of the stream properties of channel %d", __FUNCTION__, channel.iUniqueId);
+      break;
+    }
+
+    PVR_NAMED_VALUE& property = properties[*iPropertiesCount];
+    strncpy(property.strName, prop.first.c_str(), sizeof(property.strName) - 1);
+    strncpy(property.strValue, prop.second.c_str(), sizeof(property.strValue) - 1);
+    (*iPropertiesCount)++;
+  }
+
+  return PVR_ERROR_NO_ERROR;
+}
+
 int PVRIptvData::GetChannelGroupsAmount()
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  TimedLockObject lock(m_mutex);
   return m_channelGroups.GetChannelGroupsAmount();
 }
 
 PVR_ERROR PVRIptvData::GetChannelGroups(ADDON_HANDLE handle, bool bRadio)
 {
-  std::vector<PVR_CHANNEL_GROUP> channelGroups;
+  std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>> channelGroups;
   {
-    P8PLATFORM::CLockObject lock(m_mutex);
-    m_channelGroups.GetChannelGroups(channelGroups, bRadio);
+    TimedLockObject lock(m_mutex);
+    channelGroups = m_channelGroups.GetKodiChannelGroups(bRadio);
   }
 
-  Logger::Log(LEVEL_DEBUG, "%s - channel groups available '%d'", __FUNCTION__, channelGroups.size());
+  Logger::Log(LEVEL_DEBUG, "%s - channel groups available '%d'", __FUNCTION__, channelGroups->size());
 
-  for (const auto& channelGroup : channelGroups)
+  for (const auto& channelGroup : *channelGroups)
     PVR->TransferChannelGroup(handle, &channelGroup);
 
   return PVR_ERROR_NO_ERROR;
@@ -137,26 +386,106 @@ PVR_ERROR PVRIptvData::GetChannelGroups(ADDON_HANDLE handle, bool bRadio)
 
 PVR_ERROR PVRIptvData::GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP& group)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  std::shared_ptr<const std::vector<ChannelGroupMember>> channelGroupMembers;
+  {
+    TimedLockObject lock(m_mutex);
+    channelGroupMembers = m_channelGroups.GetChannelGroupMembers(group.strGroupName);
+  }
+
+  // Only the channel differs between members so the same struct is reused for each
+  PVR_CHANNEL_GROUP_MEMBER xbmcGroupMember = {0};
+  strncpy(xbmcGroupMember.strGroupName, group.strGroupName, sizeof(xbmcGroupMember.strGroupName) - 1);
+
+  for (const auto& channelGroupMember : *channelGroupMembers)
+  {
+    xbmcGroupMember.iChannelUniqueId = channelGroupMember.channelUniqueId;
+    xbmcGroupMember.iChannelNumber = channelGroupMember.channelNumber;
 
-  return m_channelGroups.GetChannelGroupMembers(handle, group);
+    PVR->TransferChannelGroupMember(handle, &xbmcGroupMember);
+  }
+
+  return PVR_ERROR_NO_ERROR;
 }
 
 PVR_ERROR PVRIptvData::GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t iStart, time_t iEnd)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  ScopedMetricTimer callTimer(MetricTimer::GET_EPG_FOR_CHANNEL);
+
+  TimedLockObject lock(m_mutex);
+
+  const PVR_ERROR error = m_epg.GetEPGForChannel(handle, iChannelUid, iStart, iEnd);
+
+  // Load a new window or retry a failed load in the background rather than blocking Kodi here,
+  // Kodi is asked to update the EPG once the refresh has loaded it
+  if (m_epg.RefreshPending())
+    m_updateScheduler.ScheduleNoLaterThan(UpdateJob::REFRESH_EPG, std::chrono::milliseconds(0));
+  else if (m_epg.LastLoadFailed())
+    m_updateScheduler.ScheduleNoLaterThan(UpdateJob::REFRESH_EPG, std::chrono::seconds(REFRESH_RETRY_MIN_SECS));
 
-  return m_epg.GetEPGForChannel(handle, iChannelUid, iStart, iEnd);
+  return error;
+}
+
+PVR_ERROR PVRIptvData::CallMenuHook(const PVR_MENUHOOK& menuhook)
+{
+  if (menuhook.iHookId != MENUHOOK_DUMP_METRICS)
+    return PVR_ERROR_INVALID_PARAMETERS;
+
+  ReportMemoryUsage("metrics dump");
+  Metrics::GetInstance().LogSummary();
+  if (Metrics::IsEnabled())
+    Metrics::GetInstance().WriteJsonFile(FileUtils::GetUserFilePath(METRICS_FILE_NAME));
+
+  return PVR_ERROR_NO_ERROR;
 }
 
 ADDON_STATUS PVRIptvData::SetSetting(const char* settingName, const void* settingValue)
 {
-  P8PLATFORM::CLockObject lock(m_mutex);
+  SettingScope scope;
+  {
+    TimedLockObject lock(m_mutex);
+    scope = Settings::GetInstance().SetValue(settingName, settingValue);
+  }
+
+  // The tracer has its own lock, writing out a long trace shouldn't hold up the EPG and channel calls
+  if (scope == SettingScope::TRACING)
+  {
+    if (!Settings::GetInstance().TraceEnabled() && Tracer::IsEnabled())
+      Tracer::GetInstance().WriteFile(FileUtils::GetUserFilePath(TRACE_FILE_NAME));
+    Tracer::GetInstance().SetEnabled(Settings::GetInstance().TraceEnabled());
+    return ADDON_STATUS_OK;
+  }
+
+  TimedLockObject lock(m_mutex);
+
+  // Kodi sets each changed setting in turn, every change pushes the job back
+  // so a number of settings changed together result in a single reload.
+  UpdateJob job;
+  switch (scope)
+  {
+    case SettingScope::PLAYLIST:
+      job = UpdateJob::RELOAD_PLAYLIST;
+      break;
+    case SettingScope::EPG:
+      job = UpdateJob::RELOAD_EPG;
+      break;
+    case SettingScope::EPG_TIMESHIFT:
+      job = UpdateJob::APPLY_EPG_TIMESHIFT;
+      break;
+    case SettingScope::LOGOS:
+      job = UpdateJob::APPLY_CHANNEL_LOGOS;
+      break;
+    case SettingScope::METRICS:
+      Metrics::GetInstance().SetEnabled(Settings::GetInstance().CollectMetrics());
+      return ADDON_STATUS_OK;
+    case SettingScope::REFRESH_INTERVALS:
+      ScheduleRefresh(UpdateJob::RELOAD_PLAYLIST, Settings::GetInstance().GetM3URefreshIntervalMins(), m_playlistRefreshFailures);
+      ScheduleRefresh(UpdateJob::REFRESH_EPG, Settings::GetInstance().GetEpgRefreshIntervalMins(), m_epgRefreshFailures);
+      return ADDON_STATUS_OK;
+    default:
+      return ADDON_STATUS_OK;
+  }
 
-  // When a number of settings change set this on the first one so it can be picked up
-  // in the process call for a reload of channels, groups and EPG.
-  if (!m_reloadChannelsGroupsAndEPG)
-    m_reloadChannelsGroupsAndEPG = true;
+  m_updateScheduler.Schedule(job, std::chrono::milliseconds(SETTINGS_RELOAD_DELAY_MS));
 
-  return Settings::GetInstance().SetValue(settingName, settingValue);
+  return ADDON_STATUS_OK;
 }
\ No newline at end of file
@@ -30,9 +30,15 @@
 #include "iptvsimple/ChannelGroups.h"
 #include "iptvsimple/Epg.h"
 #include "iptvsimple/PlaylistLoader.h"
+#include "iptvsimple/UpdateScheduler.h"
 #include "iptvsimple/data/Channel.h"
+#include "iptvsimple/utilities/CancellationToken.h"
 
 #include <atomic>
+#include <memory>
+#include <random>
+
+static const unsigned int MENUHOOK_DUMP_METRICS = 1;
 
 class PVRIptvData : public P8PLATFORM::CThread
 {
@@ -44,23 +50,47 @@ public:
   int GetChannelsAmount();
   PVR_ERROR GetChannels(ADDON_HANDLE handle, bool bRadio);
   bool GetChannel(const PVR_CHANNEL& channel, iptvsimple::data::Channel& myChannel);
+  PVR_ERROR GetChannelStreamProperties(const PVR_CHANNEL& channel, PVR_NAMED_VALUE* properties, unsigned int* iPropertiesCount);
   int GetChannelGroupsAmount();
   PVR_ERROR GetChannelGroups(ADDON_HANDLE handle, bool bRadio);
   PVR_ERROR GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP& group);
   PVR_ERROR GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t iStart, time_t iEnd);
+  PVR_ERROR CallMenuHook(const PVR_MENUHOOK& menuhook);
   ADDON_STATUS SetSetting(const char* settingName, const void* settingValue);
+  /**
+   * Whether the startup load on the update thread has finished, successfully or not
+   */
+  bool IsStartupLoadComplete() const { return m_startupLoadComplete; }
 
 protected:
   void* Process() override;
 
 private:
-  static const int PROCESS_LOOP_WAIT_SECS = 2;
+  static const int SETTINGS_RELOAD_DELAY_MS = 1000;
+  static const int REFRESH_RETRY_MIN_SECS = 30;
+  static const int REFRESH_RETRY_MAX_SECS = 3600;
+  static const int REFRESH_JITTER_PERCENT = 10;
+
+  void PublishChannelStreamProperties();
+  void ReportMemoryUsage(const char* phase);
+  void ScheduleRefresh(iptvsimple::UpdateJob job, int intervalMins, int failures);
+
+  P8PLATFORM::CMutex m_mutex;
+  // Cancelled on shutdown so a fetch in progress on the update thread stops at its next read
+  iptvsimple::utilities::CancellationToken m_fetchCancellationToken;
 
   iptvsimple::Channels m_channels;
   iptvsimple::ChannelGroups m_channelGroups{m_channels};
-  iptvsimple::PlaylistLoader m_playlistLoader{m_channels, m_channelGroups};
-  iptvsimple::Epg m_epg{m_channels};
+  iptvsimple::PlaylistLoader m_playlistLoader{m_channels, m_channelGroups, m_mutex, m_fetchCancellationToken};
+  iptvsimple::Epg m_epg{m_channels, m_fetchCancellationToken};
 
-  P8PLATFORM::CMutex m_mutex;
-  std::atomic_bool m_reloadChannelsGroupsAndEPG{false};
+  iptvsimple::UpdateScheduler m_updateScheduler;
+  bool m_playlistLoadedFromSnapshot = false;
+  std::atomic_bool m_startupLoadComplete{false};
+  std::atomic_int m_playlistRefreshFailures{0};
+  std::atomic_int m_epgRefreshFailures{0};
+  std::mt19937 m_randomGenerator{std::random_device{}()};
+
+  // Read without taking m_mutex when changing channel, always accessed through std::atomic_load/atomic_store
+  std::shared_ptr<const iptvsimple::ChannelStreamProperties> m_channelStreamProperties;
 };
\ No newline at end of file
@@ -27,10 +27,14 @@
 #include "PVRIptvData.h"
 #include "iptvsimple/Settings.h"
 #include "iptvsimple/data/Channel.h"
+#include "iptvsimple/utilities/FileUtils.h"
 #include "iptvsimple/utilities/Logger.h"
+#include "iptvsimple/utilities/Tracer.h"
 #include "kodi/xbmc_pvr_dll.h"
 #include "p8-platform/util/util.h"
 
+#include <chrono>
+
 using namespace ADDON;
 using namespace iptvsimple;
 using namespace iptvsimple::data;
@@ -49,7 +53,6 @@ using namespace iptvsimple::utilities;
 bool m_created = false;
 ADDON_STATUS m_currentStatus = ADDON_STATUS_UNKNOWN;
 PVRIptvData* m_data = nullptr;
-Channel m_currentChannel;
 Settings& settings = Settings::GetInstance();
 
 /* User adjustable settings are saved here.
@@ -64,6 +67,8 @@ extern "C"
 {
 ADDON_STATUS ADDON_Create(void* hdl, void* props)
 {
+  const std::chrono::steady_clock::time_point createStart = std::chrono::steady_clock::now();
+
   if (!hdl || !props)
   {
     return ADDON_STATUS_UNKNOWN;
@@ -123,6 +128,10 @@ ADDON_STATUS ADDON_Create(void* hdl, void* props)
 
   settings.ReadFromAddon(userPath, clientPath);
 
+  // Tracing can only start once the settings are read, the span still covers all of ADDON_Create
+  Tracer::GetInstance().SetEnabled(settings.TraceEnabled());
+  ScopedTraceSpan span(__FUNCTION__, createStart);
+
   m_data = new PVRIptvData;
   if (!m_data->Start())
   {
@@ -133,6 +142,12 @@ ADDON_STATUS ADDON_Create(void* hdl, void* props)
     return m_currentStatus;
   }
 
+  PVR_MENUHOOK menuHook = {0};
+  menuHook.iHookId = MENUHOOK_DUMP_METRICS;
+  menuHook.iLocalizedStringId = 30052;
+  menuHook.category = PVR_MENUHOOK_SETTING;
+  PVR->AddMenuHook(&menuHook);
+
   m_currentStatus = ADDON_STATUS_OK;
   m_created = true;
 
@@ -146,13 +161,22 @@ ADDON_STATUS ADDON_GetStatus()
 
 void ADDON_Destroy()
 {
-  delete m_data;
+  {
+    ScopedTraceSpan span(__FUNCTION__);
+    delete m_data;
+  }
+
+  if (Tracer::IsEnabled())
+    Tracer::GetInstance().WriteFile(FileUtils::GetUserFilePath(TRACE_FILE_NAME));
+
   m_created = false;
   m_currentStatus = ADDON_STATUS_UNKNOWN;
 }
 
 ADDON_STATUS ADDON_SetSetting(const char* settingName, const void* settingValue)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (!XBMC || !m_data)
     return ADDON_STATUS_OK;
 
@@ -217,6 +241,8 @@ PVR_ERROR GetDriveSpace(long long* iTotal, long long* iUsed)
 
 PVR_ERROR GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t iStart, time_t iEnd)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetEPGForChannel(handle, iChannelUid, iStart, iEnd);
 
@@ -225,6 +251,8 @@ PVR_ERROR GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t iStart,
 
 int GetChannelsAmount(void)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetChannelsAmount();
 
@@ -233,6 +261,8 @@ int GetChannelsAmount(void)
 
 PVR_ERROR GetChannels(ADDON_HANDLE handle, bool bRadio)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetChannels(handle, bRadio);
 
@@ -241,34 +271,24 @@ PVR_ERROR GetChannels(ADDON_HANDLE handle, bool bRadio)
 
 PVR_ERROR GetChannelStreamProperties(const PVR_CHANNEL* channel, PVR_NAMED_VALUE* properties, unsigned int* iPropertiesCount)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (!channel || !properties || !iPropertiesCount)
     return PVR_ERROR_SERVER_ERROR;
 
   if (*iPropertiesCount < 1)
     return PVR_ERROR_INVALID_PARAMETERS;
 
-  if (m_data && m_data->GetChannel(*channel, m_currentChannel))
-  {
-    strncpy(properties[0].strName, PVR_STREAM_PROPERTY_STREAMURL, sizeof(properties[0].strName) - 1);
-    strncpy(properties[0].strValue, m_currentChannel.GetStreamURL().c_str(), sizeof(properties[0].strValue) - 1);
-    *iPropertiesCount = 1;
-    if (!m_currentChannel.GetProperties().empty())
-    {
-      for (auto& prop : m_currentChannel.GetProperties())
-      {
-        strncpy(properties[*iPropertiesCount].strName, prop.first.c_str(), sizeof(properties[*iPropertiesCount].strName) - 1);
-        strncpy(properties[*iPropertiesCount].strValue, prop.second.c_str(), sizeof(properties[*iPropertiesCount].strName) - 1);
-        (*iPropertiesCount)++;
-      }
-    }
-    return PVR_ERROR_NO_ERROR;
-  }
+  if (m_data)
+    return m_data->GetChannelStreamProperties(*channel, properties, iPropertiesCount);
 
   return PVR_ERROR_SERVER_ERROR;
 }
 
 int GetChannelGroupsAmount(void)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetChannelGroupsAmount();
 
@@ -277,6 +297,8 @@ int GetChannelGroupsAmount(void)
 
 PVR_ERROR GetChannelGroups(ADDON_HANDLE handle, bool bRadio)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetChannelGroups(handle, bRadio);
 
@@ -285,12 +307,24 @@ PVR_ERROR GetChannelGroups(ADDON_HANDLE handle, bool bRadio)
 
 PVR_ERROR GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP& group)
 {
+  ScopedTraceSpan span(__FUNCTION__);
+
   if (m_data)
     return m_data->GetChannelGroupMembers(handle, group);
 
   return PVR_ERROR_SERVER_ERROR;
 }
 
+PVR_ERROR CallMenuHook(const PVR_MENUHOOK& menuhook, const PVR_MENUHOOK_DATA& item)
+{
+  ScopedTraceSpan span(__FUNCTION__);
+
+  if (m_data)
+    return m_data->CallMenuHook(menuhook);
+
+  return PVR_ERROR_SERVER_ERROR;
+}
+
 PVR_ERROR SignalStatus(PVR_SIGNAL_STATUS& signalStatus)
 {
   snprintf(signalStatus.strAdapterName, sizeof(signalStatus.strAdapterName), "IPTV Simple Adapter 1");
@@ -305,7 +339,6 @@ int GetRecordingsAmount(bool deleted) { return -1; }
 PVR_ERROR GetRecordings(ADDON_HANDLE handle, bool deleted) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR GetRecordingStreamProperties(const PVR_RECORDING*, PVR_NAMED_VALUE*, unsigned int*) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR OpenDialogChannelScan(void) { return PVR_ERROR_NOT_IMPLEMENTED; }
-PVR_ERROR CallMenuHook(const PVR_MENUHOOK& menuhook, const PVR_MENUHOOK_DATA& item) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR DeleteChannel(const PVR_CHANNEL& channel) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR RenameChannel(const PVR_CHANNEL& channel) { return PVR_ERROR_NOT_IMPLEMENTED; }
 PVR_ERROR OpenDialogChannelSettings(const PVR_CHANNEL& channel) { return PVR_ERROR_NOT_IMPLEMENTED; }
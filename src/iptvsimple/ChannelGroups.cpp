@@ -24,6 +24,7 @@
 
 #include "../client.h"
 #include "utilities/Logger.h"
+#include "utilities/MemoryUtils.h"
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
@@ -34,6 +35,35 @@ ChannelGroups::ChannelGroups(const Channels& channels) : m_channels(channels) {}
 void ChannelGroups::Clear()
 {
   m_channelGroups.clear();
+  m_channelGroupIdsByName.clear();
+  m_channelGroupIndexesById.clear();
+  Invalidate();
+}
+
+void ChannelGroups::Invalidate()
+{
+  m_kodiTvChannelGroups.reset();
+  m_kodiRadioChannelGroups.reset();
+  m_channelGroupMembersByName.clear();
+}
+
+void ChannelGroups::InvalidateIfChannelsChanged() const
+{
+  if (m_channelsGeneration != m_channels.GetGeneration())
+  {
+    const_cast<ChannelGroups*>(this)->Invalidate();
+    m_channelsGeneration = m_channels.GetGeneration();
+  }
+}
+
+void ChannelGroups::Swap(ChannelGroups& other)
+{
+  // Only the groups are swapped, each instance keeps the channels it was created with
+  m_channelGroups.swap(other.m_channelGroups);
+  m_channelGroupIdsByName.swap(other.m_channelGroupIdsByName);
+  m_channelGroupIndexesById.swap(other.m_channelGroupIndexesById);
+  Invalidate();
+  other.Invalidate();
 }
 
 int ChannelGroups::GetChannelGroupsAmount() const
@@ -41,49 +71,60 @@ int ChannelGroups::GetChannelGroupsAmount() const
   return m_channelGroups.size();
 }
 
-void ChannelGroups::GetChannelGroups(std::vector<PVR_CHANNEL_GROUP>& kodiChannelGroups, bool radio) const
+std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>> ChannelGroups::GetKodiChannelGroups(bool radio) const
 {
-  Logger::Log(LEVEL_DEBUG, "%s - Starting to get ChannelGroups for PVR", __FUNCTION__);
+  InvalidateIfChannelsChanged();
+
+  std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>>& kodiChannelGroups = radio ? m_kodiRadioChannelGroups : m_kodiTvChannelGroups;
+  if (kodiChannelGroups)
+    return kodiChannelGroups;
+
+  std::shared_ptr<std::vector<PVR_CHANNEL_GROUP>> newKodiChannelGroups = std::make_shared<std::vector<PVR_CHANNEL_GROUP>>();
 
   for (const auto& channelGroup : m_channelGroups)
   {
-    Logger::Log(LEVEL_DEBUG, "%s - Transfer channelGroup '%s', ChannelGroupIndex '%d'", __FUNCTION__, channelGroup.GetGroupName().c_str(), channelGroup.GetUniqueId());
-
     if (channelGroup.IsRadio() == radio)
     {
       PVR_CHANNEL_GROUP kodiChannelGroup = {0};
 
       channelGroup.UpdateTo(kodiChannelGroup);
 
-      kodiChannelGroups.emplace_back(kodiChannelGroup);
+      newKodiChannelGroups->emplace_back(kodiChannelGroup);
     }
   }
 
-  Logger::Log(LEVEL_DEBUG, "%s - Finished getting ChannelGroups for PVR", __FUNCTION__);
+  Logger::Log(LEVEL_DEBUG, "%s - Built %d channel groups for transfer, radio = %d", __FUNCTION__, newKodiChannelGroups->size(), radio);
+
+  kodiChannelGroups = newKodiChannelGroups;
+  return kodiChannelGroups;
 }
 
-PVR_ERROR ChannelGroups::GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP& group)
+std::shared_ptr<const std::vector<ChannelGroupMember>> ChannelGroups::GetChannelGroupMembers(const std::string& groupName) const
 {
-  const ChannelGroup* myGroup = FindChannelGroup(group.strGroupName);
+  InvalidateIfChannelsChanged();
+
+  auto channelGroupMembersPair = m_channelGroupMembersByName.find(groupName);
+  if (channelGroupMembersPair != m_channelGroupMembersByName.end())
+    return channelGroupMembersPair->second;
+
+  std::shared_ptr<std::vector<ChannelGroupMember>> channelGroupMembers = std::make_shared<std::vector<ChannelGroupMember>>();
+
+  const ChannelGroup* myGroup = FindChannelGroup(groupName);
   if (myGroup)
   {
+    channelGroupMembers->reserve(myGroup->GetMemberChannelIndexes().size());
+
     for (int memberId : myGroup->GetMemberChannelIndexes())
     {
       if (memberId < 0 || memberId >= static_cast<int>(m_channels.GetChannelsAmount()))
         continue;
 
-      const Channel& channel = m_channels.GetChannelsList().at(memberId);
-      PVR_CHANNEL_GROUP_MEMBER xbmcGroupMember = {0};
-
-      strncpy(xbmcGroupMember.strGroupName, group.strGroupName, sizeof(xbmcGroupMember.strGroupName) - 1);
-      xbmcGroupMember.iChannelUniqueId = channel.GetUniqueId();
-      xbmcGroupMember.iChannelNumber = channel.GetChannelNumber();
-
-      PVR->TransferChannelGroupMember(handle, &xbmcGroupMember);
+      channelGroupMembers->push_back({m_channels.GetChannelUniqueIds()[memberId], m_channels.GetChannelNumbers()[memberId]});
     }
   }
 
-  return PVR_ERROR_NO_ERROR;
+  m_channelGroupMembersByName.insert({groupName, channelGroupMembers});
+  return channelGroupMembers;
 }
 
 int ChannelGroups::AddChannelGroup(iptvsimple::data::ChannelGroup& channelGroup)
@@ -94,7 +135,10 @@ int ChannelGroups::AddChannelGroup(iptvsimple::data::ChannelGroup& channelGroup)
   {
     channelGroup.SetUniqueId(m_channelGroups.size() + 1);
 
+    m_channelGroupIdsByName.insert({channelGroup.GetGroupName(), channelGroup.GetUniqueId()});
+    m_channelGroupIndexesById.insert({channelGroup.GetUniqueId(), m_channelGroups.size()});
     m_channelGroups.emplace_back(channelGroup);
+    Invalidate();
 
     Logger::Log(LEVEL_DEBUG, "%s - Added group: %s, with uniqueId: %d", __FUNCTION__, channelGroup.GetGroupName().c_str(), channelGroup.GetUniqueId());
 
@@ -106,24 +150,56 @@ int ChannelGroups::AddChannelGroup(iptvsimple::data::ChannelGroup& channelGroup)
   return existingChannelGroup->GetUniqueId();
 }
 
-ChannelGroup* ChannelGroups::GetChannelGroup(int uniqueId)
+bool ChannelGroups::AddMemberChannelIndex(int uniqueId, int channelIndex)
 {
-  for (auto& myChannelGroup : m_channelGroups)
-  {
-    if (myChannelGroup.GetUniqueId() == uniqueId)
-      return &myChannelGroup;
-  }
+  auto channelGroupIndexPair = m_channelGroupIndexesById.find(uniqueId);
+  if (channelGroupIndexPair == m_channelGroupIndexesById.end())
+    return false;
+
+  // The members of the group as built for Kodi have to be rebuilt
+  Invalidate();
+
+  m_channelGroups[channelGroupIndexPair->second].AddMemberChannelIndex(channelIndex);
+  return true;
+}
+
+const ChannelGroup* ChannelGroups::GetChannelGroup(int uniqueId) const
+{
+  auto channelGroupIndexPair = m_channelGroupIndexesById.find(uniqueId);
+  if (channelGroupIndexPair != m_channelGroupIndexesById.end())
+    return &m_channelGroups.at(channelGroupIndexPair->second);
 
   return nullptr;
 }
 
-ChannelGroup* ChannelGroups::FindChannelGroup(const std::string& name)
+const ChannelGroup* ChannelGroups::FindChannelGroup(const std::string& name) const
 {
-  for (auto& myGroup : m_channelGroups)
+  auto channelGroupIdPair = m_channelGroupIdsByName.find(name);
+  if (channelGroupIdPair != m_channelGroupIdsByName.end())
+    return GetChannelGroup(channelGroupIdPair->second);
+
+  return nullptr;
+}
+
+size_t ChannelGroups::GetMemoryUsage() const
+{
+  size_t size = MemoryUtils::GetHeapSize(m_channelGroups);
+  for (const auto& channelGroup : m_channelGroups)
+    size += channelGroup.GetMemoryUsage();
+
+  size += MemoryUtils::GetHeapSize(m_channelGroupIdsByName) + MemoryUtils::GetHeapSize(m_channelGroupIndexesById);
+
+  if (m_kodiTvChannelGroups)
+    size += MemoryUtils::GetHeapSize(*m_kodiTvChannelGroups);
+  if (m_kodiRadioChannelGroups)
+    size += MemoryUtils::GetHeapSize(*m_kodiRadioChannelGroups);
+
+  for (const auto& channelGroupMembersPair : m_channelGroupMembersByName)
   {
-    if (myGroup.GetGroupName() == name)
-      return &myGroup;
+    size += MemoryUtils::GetHeapSize(channelGroupMembersPair.first) + sizeof(channelGroupMembersPair) + 2 * sizeof(void*);
+    if (channelGroupMembersPair.second)
+      size += MemoryUtils::GetHeapSize(*channelGroupMembersPair.second);
   }
 
-  return nullptr;
-}
\ No newline at end of file
+  return size;
+}
@@ -26,28 +26,54 @@
 #include "Channels.h"
 #include "data/ChannelGroup.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace iptvsimple
 {
+  struct ChannelGroupMember
+  {
+    int channelUniqueId;
+    int channelNumber;
+  };
+
   class ChannelGroups
   {
   public:
     ChannelGroups(const iptvsimple::Channels& channels);
 
     int GetChannelGroupsAmount() const;
-    void GetChannelGroups(std::vector<PVR_CHANNEL_GROUP>& kodiChannelGroups, bool radio) const;
-    PVR_ERROR GetChannelGroupMembers(ADDON_HANDLE handle, const PVR_CHANNEL_GROUP& group);
+    std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>> GetKodiChannelGroups(bool radio) const;
+    std::shared_ptr<const std::vector<ChannelGroupMember>> GetChannelGroupMembers(const std::string& groupName) const;
 
     int AddChannelGroup(iptvsimple::data::ChannelGroup& channelGroup);
-    iptvsimple::data::ChannelGroup* GetChannelGroup(int uniqueId);
-    iptvsimple::data::ChannelGroup* FindChannelGroup(const std::string& name);
+    bool AddMemberChannelIndex(int uniqueId, int channelIndex);
+    const iptvsimple::data::ChannelGroup* GetChannelGroup(int uniqueId) const;
+    const iptvsimple::data::ChannelGroup* FindChannelGroup(const std::string& name) const;
     const std::vector<data::ChannelGroup>& GetChannelGroupsList() const { return m_channelGroups; }
     void Clear();
+    void Swap(ChannelGroups& other);
+    /**
+     * Estimate of the heap memory held by the groups, their member lists and the groups built for Kodi
+     */
+    size_t GetMemoryUsage() const;
 
   private:
+    void Invalidate();
+    void InvalidateIfChannelsChanged() const;
+
     const iptvsimple::Channels& m_channels;
     std::vector<iptvsimple::data::ChannelGroup> m_channelGroups;
+    std::unordered_map<std::string, int> m_channelGroupIdsByName;
+    std::unordered_map<int, size_t> m_channelGroupIndexesById;
+
+    // The groups and their members as transferred to Kodi, built on first use. The members
+    // depend on the channels so these are also rebuilt when the channel generation changes.
+    mutable unsigned int m_channelsGeneration = 0;
+    mutable std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>> m_kodiTvChannelGroups;
+    mutable std::shared_ptr<const std::vector<PVR_CHANNEL_GROUP>> m_kodiRadioChannelGroups;
+    mutable std::unordered_map<std::string, std::shared_ptr<const std::vector<ChannelGroupMember>>> m_channelGroupMembersByName;
   };
 } //namespace iptvsimple
\ No newline at end of file
@@ -27,22 +27,64 @@
 #include "Settings.h"
 #include "utilities/FileUtils.h"
 #include "utilities/Logger.h"
+#include "utilities/MemoryUtils.h"
 
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <utility>
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
 using namespace iptvsimple::utilities;
 
+namespace
+{
+
+// Generations are unique across all instances so they still tell lists apart after a swap
+std::atomic<unsigned int> nextGeneration{1};
+
+ChannelStreamProperties::StreamProperties CreateChannelStreamProperties(const Channel& channel)
+{
+  ChannelStreamProperties::StreamProperties streamProperties;
+  streamProperties.reserve(channel.GetProperties().size() + 1);
+
+  streamProperties.emplace_back(PVR_STREAM_PROPERTY_STREAMURL, channel.GetStreamURL());
+  for (const auto& prop : channel.GetProperties())
+    streamProperties.emplace_back(prop.first, prop.second);
+
+  return streamProperties;
+}
+
+} // unnamed namespace
+
 Channels::Channels() 
   : m_logoLocation(Settings::GetInstance().GetLogoLocation()), 
-    m_currentChannelNumber(Settings::GetInstance().GetStartChannelNumber()) {}
+    m_currentChannelNumber(Settings::GetInstance().GetStartChannelNumber()),
+    m_generation(nextGeneration++) {}
+
+void Channels::Invalidate()
+{
+  m_generation = nextGeneration++;
+  m_kodiTvChannels.reset();
+  m_kodiRadioChannels.reset();
+}
 
 void Channels::Clear()
 {
   m_channels.clear();
+  m_channelUniqueIds.clear();
+  m_channelNumbers.clear();
+  m_channelTvgShifts.clear();
+  m_channelRadios.clear();
+  m_channelIndexesByUniqueId.clear();
+  m_channelIndexesByTvgId.clear();
+  m_channelIndexesByTvgName.clear();
+  m_channelIndexesByName.clear();
   m_logoLocation = Settings::GetInstance().GetLogoLocation();
   m_currentChannelNumber = Settings::GetInstance().GetStartChannelNumber();
+  Invalidate();
 }
 
 int Channels::GetChannelsAmount() const
@@ -50,111 +92,245 @@ int Channels::GetChannelsAmount() const
   return m_channels.size();
 }
 
-void Channels::GetChannels(std::vector<PVR_CHANNEL>& kodiChannels, bool radio) const
+std::shared_ptr<const std::vector<PVR_CHANNEL>> Channels::GetKodiChannels(bool radio) const
 {
-  for (const auto& channel : m_channels)
+  std::shared_ptr<const std::vector<PVR_CHANNEL>>& kodiChannels = radio ? m_kodiRadioChannels : m_kodiTvChannels;
+  if (kodiChannels)
+    return kodiChannels;
+
+  std::shared_ptr<std::vector<PVR_CHANNEL>> newKodiChannels = std::make_shared<std::vector<PVR_CHANNEL>>();
+  newKodiChannels->reserve(std::count(m_channelRadios.begin(), m_channelRadios.end(), radio));
+
+  for (size_t i = 0; i < m_channelRadios.size(); i++)
   {
-    if (channel.IsRadio() == radio)
+    if (m_channelRadios[i] == radio)
     {
-      Logger::Log(LEVEL_DEBUG, "%s - Transfer channel '%s', ChannelIndex '%d'", __FUNCTION__, channel.GetChannelName().c_str(),
-                  channel.GetUniqueId());
       PVR_CHANNEL kodiChannel = {0};
 
-      channel.UpdateTo(kodiChannel);
+      m_channels[i].UpdateTo(kodiChannel);
 
-      kodiChannels.emplace_back(kodiChannel);
+      newKodiChannels->emplace_back(kodiChannel);
     }
   }
+
+  Logger::Log(LEVEL_DEBUG, "%s - Built %d channels for transfer, generation %u, radio = %d", __FUNCTION__,
+              newKodiChannels->size(), m_generation, radio);
+
+  kodiChannels = newKodiChannels;
+  return kodiChannels;
+}
+
+std::shared_ptr<const ChannelStreamProperties> Channels::CreateStreamProperties() const
+{
+  std::shared_ptr<ChannelStreamProperties> channelStreamProperties = std::make_shared<ChannelStreamProperties>();
+  channelStreamProperties->channelsGeneration = m_generation;
+  channelStreamProperties->streamPropertiesByUniqueId.reserve(m_channels.size());
+
+  for (const auto& channel : m_channels)
+    channelStreamProperties->streamPropertiesByUniqueId.insert({channel.GetUniqueId(), CreateChannelStreamProperties(channel)});
+
+  return channelStreamProperties;
+}
+
+bool Channels::GetChannelStreamProperties(int uniqueId, ChannelStreamProperties::StreamProperties& streamProperties) const
+{
+  const Channel* channel = GetChannel(uniqueId);
+  if (!channel)
+    return false;
+
+  streamProperties = CreateChannelStreamProperties(*channel);
+  return true;
 }
 
-bool Channels::GetChannel(const PVR_CHANNEL& channel, Channel& myChannel)
+bool Channels::GetChannel(const PVR_CHANNEL& channel, Channel& myChannel) const
 {
-  for (const auto& thisChannel : m_channels)
+  const Channel* thisChannel = GetChannel(static_cast<int>(channel.iUniqueId));
+  if (thisChannel)
   {
-    if (thisChannel.GetUniqueId() == static_cast<int>(channel.iUniqueId))
-    {
-      thisChannel.UpdateTo(myChannel);
+    thisChannel->UpdateTo(myChannel);
 
-      return true;
-    }
+    return true;
   }
 
   return false;
 }
 
-void Channels::AddChannel(Channel& channel, std::vector<int>& groupIdList, ChannelGroups& channelGroups)
+void Channels::AddChannel(Channel&& channel, std::vector<int>& groupIdList, ChannelGroups& channelGroups)
 {
   m_currentChannelNumber = channel.GetChannelNumber();
-  channel.SetUniqueId(GenerateChannelId(channel.GetChannelName().c_str(), channel.GetStreamURL().c_str()));
+  channel.SetUniqueId(GenerateChannelId(channel.GetChannelName(), channel.GetStreamURL()));
 
   for (int myGroupId : groupIdList)
   {
-    channel.SetRadio(channelGroups.GetChannelGroup(myGroupId)->IsRadio());
-    channelGroups.GetChannelGroup(myGroupId)->AddMemberChannelIndex(m_channels.size());
+    const ChannelGroup* channelGroup = channelGroups.GetChannelGroup(myGroupId);
+    if (!channelGroup)
+      continue;
+
+    channel.SetRadio(channelGroup->IsRadio());
+    channelGroups.AddMemberChannelIndex(myGroupId, m_channels.size());
   }
 
-  m_channels.emplace_back(channel);
+  // Resolve the logo straight away as channels are published while the playlist is still loading
+  ApplyChannelLogo(channel);
+
+  StoreChannel(std::move(channel));
 
   m_currentChannelNumber++;
 }
 
-Channel* Channels::GetChannel(int uniqueId)
+void Channels::RestoreChannel(Channel&& channel)
 {
-  for (auto& myChannel : m_channels)
-  {
-    if (myChannel.GetUniqueId() == uniqueId)
-      return &myChannel;
-  }
+  // Restored channels keep their unique id and logo path, group membership is restored with the groups
+  m_currentChannelNumber = channel.GetChannelNumber() + 1;
+
+  StoreChannel(std::move(channel));
+}
+
+void Channels::ReserveChannels(size_t amount)
+{
+  m_channels.reserve(amount);
+  m_channelUniqueIds.reserve(amount);
+  m_channelNumbers.reserve(amount);
+  m_channelTvgShifts.reserve(amount);
+  m_channelRadios.reserve(amount);
+}
+
+void Channels::StoreChannel(Channel&& channel)
+{
+  Invalidate();
+
+  const size_t channelIndex = m_channels.size();
+
+  // insert() keeps the existing entry so each index refers to the first channel with that key
+  m_channelIndexesByUniqueId.insert({channel.GetUniqueId(), channelIndex});
+  m_channelIndexesByTvgId.insert({channel.GetTvgId(), channelIndex});
+  m_channelIndexesByTvgName.insert({channel.GetTvgName(), channelIndex});
+  m_channelIndexesByName.insert({channel.GetChannelName(), channelIndex});
+
+  m_channelUniqueIds.emplace_back(channel.GetUniqueId());
+  m_channelNumbers.emplace_back(channel.GetChannelNumber());
+  m_channelTvgShifts.emplace_back(channel.GetTvgShift());
+  m_channelRadios.push_back(channel.IsRadio());
+
+  m_channels.emplace_back(std::move(channel));
+}
+
+const Channel* Channels::GetChannel(int uniqueId) const
+{
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair != m_channelIndexesByUniqueId.end())
+    return &m_channels.at(channelIndexPair->second);
 
   return nullptr;
 }
 
+bool Channels::SetChannelLogoPath(int uniqueId, const std::string& logoPath)
+{
+  auto channelIndexPair = m_channelIndexesByUniqueId.find(uniqueId);
+  if (channelIndexPair == m_channelIndexesByUniqueId.end())
+    return false;
+
+  // The logo is part of what is transferred to Kodi so anything built from the channels has to be rebuilt
+  Invalidate();
+
+  m_channels[channelIndexPair->second].SetLogoPath(logoPath);
+  return true;
+}
+
 const Channel* Channels::FindChannel(const std::string& id, const std::string& name) const
 {
-  const std::string tvgName = std::regex_replace(name, std::regex(" "), "_");
+  // The first channel matching on any of the keys wins, as the matches
+  // come from separate indexes that is the one with the lowest index
+  size_t foundIndex = m_channels.size();
 
-  for (const auto& myChannel : m_channels)
-  {
-    if (myChannel.GetTvgId() == id)
-      return &myChannel;
+  auto channelIndexPair = m_channelIndexesByTvgId.find(id);
+  if (channelIndexPair != m_channelIndexesByTvgId.end())
+    foundIndex = channelIndexPair->second;
 
-    if (tvgName.empty())
-      continue;
+  std::string tvgName = name;
+  std::replace(tvgName.begin(), tvgName.end(), ' ', '_');
 
-    if (myChannel.GetTvgName() == tvgName)
-      return &myChannel;
+  if (!tvgName.empty())
+  {
+    channelIndexPair = m_channelIndexesByTvgName.find(tvgName);
+    if (channelIndexPair != m_channelIndexesByTvgName.end())
+      foundIndex = std::min(foundIndex, channelIndexPair->second);
 
-    if (myChannel.GetChannelName() == name)
-      return &myChannel;
+    channelIndexPair = m_channelIndexesByName.find(name);
+    if (channelIndexPair != m_channelIndexesByName.end())
+      foundIndex = std::min(foundIndex, channelIndexPair->second);
   }
 
+  if (foundIndex < m_channels.size())
+    return &m_channels[foundIndex];
+
   return nullptr;
 }
 
+size_t Channels::GetMemoryUsage() const
+{
+  size_t size = MemoryUtils::GetHeapSize(m_logoLocation) + MemoryUtils::GetHeapSize(m_channels);
+  for (const auto& channel : m_channels)
+    size += channel.GetMemoryUsage();
+
+  size += MemoryUtils::GetHeapSize(m_channelUniqueIds) + MemoryUtils::GetHeapSize(m_channelNumbers) +
+          MemoryUtils::GetHeapSize(m_channelTvgShifts) + m_channelRadios.capacity() / 8;
+
+  size += MemoryUtils::GetHeapSize(m_channelIndexesByUniqueId) + MemoryUtils::GetHeapSize(m_channelIndexesByTvgId) +
+          MemoryUtils::GetHeapSize(m_channelIndexesByTvgName) + MemoryUtils::GetHeapSize(m_channelIndexesByName);
+
+  if (m_kodiTvChannels)
+    size += MemoryUtils::GetHeapSize(*m_kodiTvChannels);
+  if (m_kodiRadioChannels)
+    size += MemoryUtils::GetHeapSize(*m_kodiRadioChannels);
+
+  return size;
+}
+
 void Channels::ApplyChannelLogos()
 {
+  // The location is read again as this is used when the logo settings change
+  m_logoLocation = Settings::GetInstance().GetLogoLocation();
+  Invalidate();
+
   for (auto& channel : m_channels)
+    ApplyChannelLogo(channel);
+}
+
+void Channels::ApplyChannelLogo(Channel& channel) const
+{
+  if (!channel.GetTvgLogo().empty())
   {
-    if (!channel.GetTvgLogo().empty())
-    {
-      if (!m_logoLocation.empty() && channel.GetTvgLogo().find("://") == std::string::npos) // special proto
-        channel.SetLogoPath(FileUtils::PathCombine(m_logoLocation, channel.GetTvgLogo()));
-      else
-        channel.SetLogoPath(channel.GetTvgLogo());
-    }
+    if (!m_logoLocation.empty() && channel.GetTvgLogo().find("://") == std::string::npos) // special proto
+      channel.SetLogoPath(FileUtils::PathCombine(m_logoLocation, channel.GetTvgLogo()));
+    else
+      channel.SetLogoPath(channel.GetTvgLogo());
   }
 }
 
-int Channels::GenerateChannelId(const char* channelName, const char* streamUrl)
+int Channels::GenerateChannelId(const std::string& channelName, const std::string& streamUrl) const
 {
-  std::string concat(channelName);
-  concat.append(streamUrl);
+  // djb2 over the channel name followed by the stream URL, calculated in place
+  // so the ids stay the same as those already stored in Kodi's database
+  uint32_t hash = 0;
+  for (const char c : channelName)
+    hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
+  for (const char c : streamUrl)
+    hash = ((hash << 5) + hash) + c; /* hash * 33 + c */
 
-  const char* calcString = concat.c_str();
-  int iId = 0;
-  int c;
-  while ((c = *calcString++))
-    iId = ((iId << 5) + iId) + c; /* iId * 33 + c */
+  // abs() of the signed hash, without the overflow for INT_MIN
+  if (hash & 0x80000000)
+    hash = ~hash + 1;
+
+  int uniqueId = static_cast<int>(hash & 0x7FFFFFFF);
+
+  // Duplicate ids would shadow each other in every lookup, so probe for the next free id.
+  // Channels are added in playlist order so the result is the same on every load.
+  while (uniqueId == 0 || m_channelIndexesByUniqueId.find(uniqueId) != m_channelIndexesByUniqueId.end())
+  {
+    Logger::Log(LEVEL_DEBUG, "%s - Channel id %d for '%s' is already in use, trying next id", __FUNCTION__, uniqueId, channelName.c_str());
+    uniqueId = uniqueId < INT_MAX ? uniqueId + 1 : 1;
+  }
 
-  return abs(iId);
+  return uniqueId;
 }
\ No newline at end of file
@@ -25,7 +25,10 @@
 
 #include "data/Channel.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace iptvsimple
@@ -37,30 +40,80 @@ namespace iptvsimple
     class ChannelGroup;
   }
 
+  /**
+   * The stream URL and properties of every channel, ready to be handed to Kodi.
+   * Instances are immutable once created so they can be read without the lock.
+   */
+  struct ChannelStreamProperties
+  {
+    typedef std::vector<std::pair<std::string, std::string>> StreamProperties;
+
+    unsigned int channelsGeneration = 0;
+    std::unordered_map<int, StreamProperties> streamPropertiesByUniqueId;
+  };
+
   class Channels
   {
   public:
     Channels();
 
     int GetChannelsAmount() const;
-    void GetChannels(std::vector<PVR_CHANNEL>& kodiChannels, bool radio) const;
-    bool GetChannel(const PVR_CHANNEL& channel, iptvsimple::data::Channel& myChannel);
+    std::shared_ptr<const std::vector<PVR_CHANNEL>> GetKodiChannels(bool radio) const;
+    std::shared_ptr<const ChannelStreamProperties> CreateStreamProperties() const;
+    bool GetChannelStreamProperties(int uniqueId, ChannelStreamProperties::StreamProperties& streamProperties) const;
+    bool GetChannel(const PVR_CHANNEL& channel, iptvsimple::data::Channel& myChannel) const;
 
-    void AddChannel(iptvsimple::data::Channel& channel, std::vector<int>& groupIdList, iptvsimple::ChannelGroups& channelGroups);
-    iptvsimple::data::Channel* GetChannel(int uniqueId);
+    void AddChannel(iptvsimple::data::Channel&& channel, std::vector<int>& groupIdList, iptvsimple::ChannelGroups& channelGroups);
+    void RestoreChannel(iptvsimple::data::Channel&& channel);
+    void ReserveChannels(size_t amount);
+    const iptvsimple::data::Channel* GetChannel(int uniqueId) const;
+    bool SetChannelLogoPath(int uniqueId, const std::string& logoPath);
     const iptvsimple::data::Channel* FindChannel(const std::string& id, const std::string& name) const;
     const std::vector<data::Channel>& GetChannelsList() const { return m_channels; }
+    const std::vector<int>& GetChannelUniqueIds() const { return m_channelUniqueIds; }
+    const std::vector<int>& GetChannelNumbers() const { return m_channelNumbers; }
+    const std::vector<int>& GetChannelTvgShifts() const { return m_channelTvgShifts; }
     void Clear();
     void ApplyChannelLogos();
 
     int GetCurrentChannelNumber() const { return m_currentChannelNumber; }
+    unsigned int GetGeneration() const { return m_generation; }
+    const std::string& GetLogoLocation() const { return m_logoLocation; }
+    /**
+     * Estimate of the heap memory held by the channels, their indexes and the channels built for Kodi
+     */
+    size_t GetMemoryUsage() const;
 
   private:
-    int GenerateChannelId(const char* channelName, const char* streamUrl);
+    // The microbenchmarks in tools/benchmarks call the private hot paths through this
+    friend class BenchmarkAccess;
+
+    void ApplyChannelLogo(iptvsimple::data::Channel& channel) const;
+    void StoreChannel(iptvsimple::data::Channel&& channel);
+    void Invalidate();
+    int GenerateChannelId(const std::string& channelName, const std::string& streamUrl) const;
 
     std::string m_logoLocation;
     int m_currentChannelNumber;
 
     std::vector<iptvsimple::data::Channel> m_channels;
+
+    // Copies of the fields scanned on every request from Kodi, stored per column so those scans
+    // don't have to stride over the channel strings. Stored channels are only changed through
+    // Channels and never in these fields, so the columns can't go stale.
+    std::vector<int> m_channelUniqueIds;
+    std::vector<int> m_channelNumbers;
+    std::vector<int> m_channelTvgShifts;
+    std::vector<bool> m_channelRadios;
+
+    std::unordered_map<int, size_t> m_channelIndexesByUniqueId;
+    std::unordered_map<std::string, size_t> m_channelIndexesByTvgId;
+    std::unordered_map<std::string, size_t> m_channelIndexesByTvgName;
+    std::unordered_map<std::string, size_t> m_channelIndexesByName;
+
+    // The channels as transferred to Kodi, built on first use for each generation of the channels
+    unsigned int m_generation;
+    mutable std::shared_ptr<const std::vector<PVR_CHANNEL>> m_kodiTvChannels;
+    mutable std::shared_ptr<const std::vector<PVR_CHANNEL>> m_kodiRadioChannels;
   };
 } //namespace iptvsimple
\ No newline at end of file
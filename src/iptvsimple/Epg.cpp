@@ -26,113 +26,209 @@
 #include "../client.h"
 #include "utilities/FileUtils.h"
 #include "utilities/Logger.h"
+#include "utilities/MemoryUtils.h"
+#include "utilities/Metrics.h"
+#include "utilities/Tracer.h"
 #include "utilities/XMLUtils.h"
 
 #include "p8-platform/util/StringUtils.h"
 #include "rapidxml/rapidxml.hpp"
 
-#include <chrono>
-#include <regex>
-#include <thread>
+#include <algorithm>
+#include <utility>
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
 using namespace iptvsimple::utilities;
 using namespace rapidxml;
 
-Epg::Epg(Channels& channels) 
-  : m_channels(channels), m_xmltvLocation(Settings::GetInstance().GetEpgLocation()), m_epgTimeShift(Settings::GetInstance().GetEpgTimeshiftSecs()), 
-    m_tsOverride(Settings::GetInstance().GetTsOverride()), m_lastStart(0), m_lastEnd(0) {}
+namespace
+{
+
+// The document is parsed in place so its memory is just the nodes and attributes, the text stays in the data
+size_t GetDomMemoryUsage(const xml_node<>* node)
+{
+  size_t size = sizeof(xml_node<>);
+  for (const xml_attribute<>* attribute = node->first_attribute(); attribute; attribute = attribute->next_attribute())
+    size += sizeof(xml_attribute<>);
+  for (const xml_node<>* childNode = node->first_node(); childNode; childNode = childNode->next_sibling())
+    size += GetDomMemoryUsage(childNode);
+  return size;
+}
+
+} // unnamed namespace
+
+XmltvDocument::~XmltvDocument()
+{
+  // Only the peaks of the transient buffers are of interest once the document is gone
+  Metrics::Set(MetricGauge::XMLTV_DOWNLOAD_BYTES, 0);
+  Metrics::Set(MetricGauge::XMLTV_INFLATED_BYTES, 0);
+  Metrics::Set(MetricGauge::XMLTV_DOM_BYTES, 0);
+}
+
+Epg::Epg(Channels& channels, const CancellationToken& cancellationToken) 
+  : m_xmltvLocation(Settings::GetInstance().GetEpgLocation()), m_epgTimeShift(Settings::GetInstance().GetEpgTimeshiftSecs()), 
+    m_tsOverride(Settings::GetInstance().GetTsOverride()), m_lastStart(0), m_lastEnd(0), m_channels(channels), m_cancellationToken(cancellationToken) {}
 
 void Epg::Clear()
 {
-  m_channelEpgs.clear();
+  ClearChannelEpgs();
   m_genres.clear();
 }
 
-bool Epg::LoadEPG(time_t start, time_t end)
+void Epg::ClearChannelEpgs()
 {
+  m_channelEpgs.clear();
+  m_channelEpgIndexesById.clear();
+  m_channelEpgIndexesByName.clear();
+  m_channelEpgIndexesByTvgName.clear();
+}
+
+bool Epg::RefreshEPG(P8PLATFORM::CMutex& mutex)
+{
+  // Only the update thread changes the location so it can be read without the lock
   if (m_xmltvLocation.empty())
+    return true;
+
+  int start;
+  int end;
   {
-    Logger::Log(LEVEL_NOTICE, "EPG file path is not configured. EPG not loaded.");
-    return false;
+    TimedLockObject lock(mutex);
+    start = m_lastStart;
+    end = m_lastEnd;
+    m_refreshPending = false;
   }
 
-  std::string data;
+  // Nothing has been requested yet, the EPG is loaded when Kodi first asks for it
+  if (start == 0 && end == 0)
+    return true;
+
+  // Fetching, parsing and building the new EPG is done without the lock so Kodi keeps getting the current EPG
+  const std::unique_ptr<XmltvDocument> xmltvDocument = FetchXMLTV();
+  if (!xmltvDocument)
+    return false;
+
+  Epg loadedEpg(m_channels, m_cancellationToken);
+  if (!LoadEPGFromDocument(xmltvDocument->rootElement, start, end, loadedEpg))
+    return false;
 
-  if (GetXMLTVFileWithRetries(data))
   {
-    char* buffer = FillBufferFromXMLTVData(data);
+    TimedLockObject lock(mutex);
+    PublishLoadedEPG(loadedEpg);
+    m_lastLoadFailed = false;
+  }
 
-    if (!buffer)
-      return false;
+  TriggerEpgUpdates();
 
-    xml_document<> xmlDoc;
-    try
-    {
-      xmlDoc.parse<0>(buffer);
-    }
-    catch (parse_error p)
-    {
-      Logger::Log(LEVEL_ERROR, "Unable parse EPG XML: %s", p.what());
-      return false;
-    }
+  return true;
+}
 
-    xml_node<>* rootElement = xmlDoc.first_node("tv");
-    if (!rootElement)
-    {
-      Logger::Log(LEVEL_ERROR, "Invalid EPG XML: no <tv> tag found");
-      return false;
-    }
+std::unique_ptr<XmltvDocument> Epg::FetchXMLTV() const
+{
+  if (m_xmltvLocation.empty())
+    return nullptr;
 
-    if (!LoadChannelEpgs(rootElement))
-      return false;
+  std::unique_ptr<XmltvDocument> xmltvDocument(new XmltvDocument());
 
-    LoadEpgEntries(rootElement, start, end);
+  if (!GetXMLTVFile(xmltvDocument->data))
+    return nullptr;
+
+  Metrics::Set(MetricGauge::XMLTV_DOWNLOAD_BYTES, xmltvDocument->data.capacity());
+
+  char* buffer = FillBufferFromXMLTVData(xmltvDocument->data);
+  if (!buffer)
+    return nullptr;
 
-    xmlDoc.clear();
+  try
+  {
+    ScopedMetricTimer parseTimer(MetricTimer::XML_PARSE);
+    ScopedTraceSpan span("rapidxml::parse");
+    xmltvDocument->document.parse<0>(buffer);
+
+    if (Metrics::IsEnabled())
+      Metrics::Set(MetricGauge::XMLTV_DOM_BYTES, GetDomMemoryUsage(&xmltvDocument->document));
   }
-  else
+  catch (parse_error p)
   {
-    return false;
+    Logger::Log(LEVEL_ERROR, "Unable parse EPG XML: %s", p.what());
+    return nullptr;
   }
 
-  LoadGenres();
+  xmltvDocument->rootElement = xmltvDocument->document.first_node("tv");
+  if (!xmltvDocument->rootElement)
+  {
+    Logger::Log(LEVEL_ERROR, "Invalid EPG XML: no <tv> tag found");
+    return nullptr;
+  }
 
-  Logger::Log(LEVEL_NOTICE, "EPG Loaded.");
+  return xmltvDocument;
+}
 
-  if (Settings::GetInstance().GetEpgLogosMode() != EpgLogosMode::IGNORE_XMLTV)
-    ApplyChannelsLogosFromEPG();
+bool Epg::BindEPG(const XmltvDocument& xmltvDocument, P8PLATFORM::CMutex& mutex)
+{
+  // Kodi hasn't asked for a window yet so load the default one, with the usual slack
+  const time_t now = time(nullptr);
+  const int start = static_cast<int>(now) - EPG_DEFAULT_PAST_DAYS * SECONDS_IN_DAY;
+  const int end = static_cast<int>(now) + EPG_DEFAULT_FUTURE_DAYS * SECONDS_IN_DAY + EPG_WINDOW_SLACK_SECS;
 
-  return true;
+  // The current EPG is kept if the new one has no channels we can use
+  Epg loadedEpg(m_channels, m_cancellationToken);
+  const bool loaded = LoadEPGFromDocument(xmltvDocument.rootElement, start, end, loadedEpg);
+
+  TimedLockObject lock(mutex);
+  if (loaded)
+    PublishLoadedEPG(loadedEpg);
+
+  m_lastLoadFailed = !loaded;
+  m_fetchInProgress = false;
+  m_lastStart = start;
+  m_lastEnd = end;
+
+  return loaded;
 }
 
-bool Epg::GetXMLTVFileWithRetries(std::string& data)
+bool Epg::LoadEPGFromDocument(xml_node<>* rootElement, int start, int end, Epg& loadedEpg) const
 {
-  int bytesRead = 0;
-  int count = 0;
+  // Only the update thread changes the channels and the EPG settings and this runs on it,
+  // so the new EPG is built from them without the lock. Only publishing it needs the lock.
+  loadedEpg.m_epgTimeShift = m_epgTimeShift;
+  loadedEpg.m_tsOverride = m_tsOverride;
 
-  while (count < 3) // max 3 tries
-  {
-    if ((bytesRead = FileUtils::GetCachedFileContents(TVG_FILE_NAME, m_xmltvLocation, data, Settings::GetInstance().UseEPGCache())) != 0)
-      break;
+  if (!loadedEpg.LoadChannelEpgs(rootElement))
+    return false;
 
-    Logger::Log(LEVEL_ERROR, "Unable to load EPG file '%s':  file is missing or empty. :%dth try.", m_xmltvLocation.c_str(), ++count);
+  loadedEpg.LoadEpgEntries(rootElement, start, end);
 
-    if (count < 3)
-      std::this_thread::sleep_for(std::chrono::microseconds(2 * 1000 * 1000)); // sleep 2 sec before next try.
-  }
+  Logger::Log(LEVEL_NOTICE, "EPG Loaded.");
+  return true;
+}
 
-  if (bytesRead == 0)
+void Epg::PublishLoadedEPG(Epg& loadedEpg)
+{
+  // The previous EPG goes to loadedEpg so it is freed after the lock is released
+  m_channelEpgs.swap(loadedEpg.m_channelEpgs);
+  m_channelEpgIndexesById.swap(loadedEpg.m_channelEpgIndexesById);
+  m_channelEpgIndexesByName.swap(loadedEpg.m_channelEpgIndexesByName);
+  m_channelEpgIndexesByTvgName.swap(loadedEpg.m_channelEpgIndexesByTvgName);
+
+  if (Settings::GetInstance().GetEpgLogosMode() != EpgLogosMode::IGNORE_XMLTV)
+    ApplyChannelsLogosFromEPG();
+}
+
+bool Epg::GetXMLTVFile(std::string& data) const
+{
+  // Retrying is left to the caller, the update thread backs off between attempts
+  if (FileUtils::GetCachedFileContents(TVG_FILE_NAME, m_xmltvLocation, data, Settings::GetInstance().UseEPGCache(),
+                                       FileUtils::CreateFetchOptions(m_cancellationToken, "XMLTV")) == 0)
   {
-    Logger::Log(LEVEL_ERROR, "Unable to load EPG file '%s':  file is missing or empty. After %d tries.", m_xmltvLocation.c_str(), count);
+    Logger::Log(LEVEL_ERROR, "Unable to load EPG file '%s':  file is missing or empty.", m_xmltvLocation.c_str());
     return false;
   }
 
   return true;
 }
 
-char* Epg::FillBufferFromXMLTVData(std::string& data)
+char* Epg::FillBufferFromXMLTVData(std::string& data) const
 {
   std::string decompressed;
   char* buffer = nullptr;
@@ -140,12 +236,17 @@ char* Epg::FillBufferFromXMLTVData(std::string& data)
   // gzip packed
   if (data[0] == '\x1F' && data[1] == '\x8B' && data[2] == '\x08')
   {
+    ScopedMetricTimer inflateTimer(MetricTimer::INFLATE);
     if (!FileUtils::GzipInflate(data, decompressed))
     {
       Logger::Log(LEVEL_ERROR, "Invalid EPG file '%s': unable to decompress file.", m_xmltvLocation.c_str());
       return nullptr;
     }
-    buffer = &(decompressed[0]);
+    Metrics::Set(MetricGauge::XMLTV_INFLATED_BYTES, decompressed.capacity());
+
+    // the buffer has to outlive this function so keep the decompressed data in place of the packed data
+    data.swap(decompressed);
+    buffer = &(data[0]);
   }
   else
   {
@@ -191,10 +292,18 @@ const XmltvFileFormat Epg::GetXMLTVFileFormat(const char* buffer)
 
 bool Epg::LoadChannelEpgs(xml_node<>* rootElement)
 {
+  ScopedTraceSpan span("Epg::LoadChannelEpgs");
+
   if (!rootElement)
     return false;
 
-  m_channelEpgs.clear();
+  ClearChannelEpgs();
+
+  size_t channelCount = 0;
+  for (xml_node<>* channelNode = rootElement->first_node("channel"); channelNode; channelNode = channelNode->next_sibling("channel"))
+    channelCount++;
+
+  m_channelEpgs.reserve(channelCount);
 
   xml_node<>* channelNode = nullptr;
   for (channelNode = rootElement->first_node("channel"); channelNode; channelNode = channelNode->next_sibling("channel"))
@@ -202,7 +311,20 @@ bool Epg::LoadChannelEpgs(xml_node<>* rootElement)
     ChannelEpg channelEpg;
 
     if (channelEpg.UpdateFrom(channelNode, m_channels))
-      m_channelEpgs.emplace_back(channelEpg);
+    {
+      // Ids are matched without case, so index them in lower case
+      std::string id = channelEpg.GetId();
+      StringUtils::ToLower(id);
+      m_channelEpgIndexesById.insert({id, m_channelEpgs.size()});
+
+      // insert() keeps the existing entry so each index refers to the first channel with that key
+      std::string tvgName = channelEpg.GetName();
+      std::replace(tvgName.begin(), tvgName.end(), ' ', '_');
+      m_channelEpgIndexesByName.insert({channelEpg.GetName(), m_channelEpgs.size()});
+      m_channelEpgIndexesByTvgName.insert({tvgName, m_channelEpgs.size()});
+
+      m_channelEpgs.emplace_back(std::move(channelEpg));
+    }
   }
 
   if (m_channelEpgs.size() == 0)
@@ -216,6 +338,8 @@ bool Epg::LoadChannelEpgs(xml_node<>* rootElement)
 
 void Epg::LoadEpgEntries(xml_node<>* rootElement, int start, int end)
 {
+  ScopedTraceSpan span("Epg::LoadEpgEntries");
+
   int minShiftTime = m_epgTimeShift;
   int maxShiftTime = m_epgTimeShift;
   if (!m_tsOverride)
@@ -223,21 +347,45 @@ void Epg::LoadEpgEntries(xml_node<>* rootElement, int start, int end)
     minShiftTime = SECONDS_IN_DAY;
     maxShiftTime = -SECONDS_IN_DAY;
 
-    for (const auto& channel : m_channels.GetChannelsList())
+    for (int tvgShift : m_channels.GetChannelTvgShifts())
     {
-      if (channel.GetTvgShift() + m_epgTimeShift < minShiftTime)
-        minShiftTime = channel.GetTvgShift() + m_epgTimeShift;
-      if (channel.GetTvgShift() + m_epgTimeShift > maxShiftTime)
-        maxShiftTime = channel.GetTvgShift() + m_epgTimeShift;
+      if (tvgShift + m_epgTimeShift < minShiftTime)
+        minShiftTime = tvgShift + m_epgTimeShift;
+      if (tvgShift + m_epgTimeShift > maxShiftTime)
+        maxShiftTime = tvgShift + m_epgTimeShift;
     }
   }
 
   ChannelEpg* channelEpg = nullptr;
+  std::string id;
+
+  // Count the entries each channel will keep so every entry vector is allocated once
+  std::vector<size_t> entryCounts(m_channelEpgs.size(), 0);
+
+  for (xml_node<>* channelNode = rootElement->first_node("programme"); channelNode; channelNode = channelNode->next_sibling("programme"))
+  {
+    if (!GetAttributeValue(channelNode, "channel", id))
+      continue;
+
+    if (!channelEpg || StringUtils::CompareNoCase(channelEpg->GetId(), id) != 0)
+    {
+      if (!(channelEpg = FindEpgForChannel(id)))
+        continue;
+    }
+
+    if (EpgEntry::IsInWindow(channelNode, start, end, minShiftTime, maxShiftTime))
+      entryCounts[channelEpg - m_channelEpgs.data()]++;
+  }
+
+  for (size_t i = 0; i < m_channelEpgs.size(); i++)
+    m_channelEpgs[i].ReserveEpgEntries(entryCounts[i]);
+
+  channelEpg = nullptr;
   int broadcastId = 0;
+  int rejectedEntries = 0;
 
   for (xml_node<>* channelNode = rootElement->first_node("programme"); channelNode; channelNode = channelNode->next_sibling("programme"))
   {
-    std::string id;
     if (!GetAttributeValue(channelNode, "channel", id))
       continue;
 
@@ -252,69 +400,108 @@ void Epg::LoadEpgEntries(xml_node<>* rootElement, int start, int end)
     {
       broadcastId++;
 
-      channelEpg->AddEpgEntry(entry);
+      channelEpg->AddEpgEntry(std::move(entry));
+    }
+    else
+    {
+      rejectedEntries++;
     }
   }
+
+  Metrics::Add(MetricCounter::EPG_ENTRIES_ACCEPTED, broadcastId);
+  Metrics::Add(MetricCounter::EPG_ENTRIES_REJECTED, rejectedEntries);
 }
 
 
-void Epg::ReloadEPG()
+void Epg::ReloadEPG(P8PLATFORM::CMutex& mutex)
+{
+  {
+    TimedLockObject lock(mutex);
+
+    m_xmltvLocation = Settings::GetInstance().GetEpgLocation();
+    m_epgTimeShift = Settings::GetInstance().GetEpgTimeshiftSecs();
+    m_tsOverride = Settings::GetInstance().GetTsOverride();
+    m_lastStart = 0;
+    m_lastEnd = 0;
+    m_lastLoadFailed = false;
+    // Requests for the EPG return nothing until it is bound rather than loading it themselves
+    m_fetchInProgress = true;
+
+    // The genres don't depend on the EPG location so they are kept
+    ClearChannelEpgs();
+  }
+
+  // Fetch, parse and bind without the lock, only publishing the result needs it
+  const std::unique_ptr<XmltvDocument> xmltvDocument = FetchXMLTV();
+  if (!xmltvDocument)
+  {
+    TimedLockObject lock(mutex);
+    m_fetchInProgress = false;
+    return;
+  }
+
+  // Clears the fetch in progress whether or not the EPG could be bound
+  if (!BindEPG(*xmltvDocument, mutex))
+    return;
+
+  TriggerEpgUpdates();
+}
+
+void Epg::ApplyTimeshiftSettings()
 {
-  m_xmltvLocation = Settings::GetInstance().GetEpgLocation();
+  // Entries are stored without the shift applied, it is only added as they are transferred
   m_epgTimeShift = Settings::GetInstance().GetEpgTimeshiftSecs();
   m_tsOverride = Settings::GetInstance().GetTsOverride();
-  m_lastStart = 0;
-  m_lastEnd = 0;
 
-  Clear();
+  TriggerEpgUpdates();
+}
 
-  if (LoadEPG(m_lastStart, m_lastEnd))
-  {
-    for (const auto& myChannel : m_channels.GetChannelsList())
-      PVR->TriggerEpgUpdate(myChannel.GetUniqueId());
-  }
+void Epg::TriggerEpgUpdates()
+{
+  for (int channelUniqueId : m_channels.GetChannelUniqueIds())
+    PVR->TriggerEpgUpdate(channelUniqueId);
 }
 
 PVR_ERROR Epg::GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t start, time_t end)
 {
-  for (const auto& myChannel : m_channels.GetChannelsList())
-  {
-    if (myChannel.GetUniqueId() != iChannelUid)
-      continue;
+  const Channel* myChannel = m_channels.GetChannel(iChannelUid);
+  if (!myChannel)
+    return PVR_ERROR_NO_ERROR;
 
-    if (start > m_lastStart || end > m_lastEnd)
-    {
-      // reload EPG for new time interval only
-      LoadEPG(start, end);
-      {
-        // doesn't matter is epg loaded or not we shouldn't try to load it for same interval
-        m_lastStart = static_cast<int>(start);
-        m_lastEnd = static_cast<int>(end);
-      }
-    }
+  // The XMLTV is already being fetched in the background, Kodi is asked to update once it is bound
+  if (m_fetchInProgress)
+    return PVR_ERROR_NO_ERROR;
 
-    ChannelEpg* channelEpg = FindEpgForChannel(myChannel);
-    if (!channelEpg || channelEpg->GetEpgEntries().size() == 0)
-      return PVR_ERROR_NO_ERROR;
+  // Only reload when the window requested is not covered by what is already loaded.
+  // Some extra time is loaded so the window moving forward doesn't reload every time.
+  // The update thread loads it, until then what is already loaded is returned.
+  if ((start < m_lastStart || end > m_lastEnd) && !m_xmltvLocation.empty())
+  {
+    // doesn't matter is epg loaded or not we shouldn't try to load it for same interval
+    m_lastStart = static_cast<int>(start);
+    m_lastEnd = static_cast<int>(end) + EPG_WINDOW_SLACK_SECS;
+    m_refreshPending = true;
+  }
 
-    int shift = m_tsOverride ? m_epgTimeShift : myChannel.GetTvgShift() + m_epgTimeShift;
+  ChannelEpg* channelEpg = FindEpgForChannel(*myChannel);
+  if (!channelEpg || channelEpg->GetEpgEntries().size() == 0)
+    return PVR_ERROR_NO_ERROR;
 
-    for (auto& epgEntry : channelEpg->GetEpgEntries())
-    {
-      if ((epgEntry.GetEndTime() + shift) < start)
-        continue;
+  int shift = m_tsOverride ? m_epgTimeShift : myChannel->GetTvgShift() + m_epgTimeShift;
 
-      EPG_TAG tag = {0};
+  for (auto& epgEntry : channelEpg->GetEpgEntries())
+  {
+    if ((epgEntry.GetEndTime() + shift) < start)
+      continue;
 
-      epgEntry.UpdateTo(tag, iChannelUid, shift, m_genres);
+    EPG_TAG tag = {0};
 
-      PVR->TransferEpgEntry(handle, &tag);
+    epgEntry.UpdateTo(tag, iChannelUid, shift, m_genres);
 
-      if ((epgEntry.GetStartTime() + shift) > end)
-        break;
-    }
+    PVR->TransferEpgEntry(handle, &tag);
 
-    return PVR_ERROR_NO_ERROR;
+    if ((epgEntry.GetStartTime() + shift) > end)
+      break;
   }
 
   return PVR_ERROR_NO_ERROR;
@@ -322,35 +509,60 @@ PVR_ERROR Epg::GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t sta
 
 ChannelEpg* Epg::FindEpgForChannel(const std::string& id)
 {
-  for (auto& myChannelEpg : m_channelEpgs)
-  {
-    if (StringUtils::CompareNoCase(myChannelEpg.GetId(), id) == 0)
-      return &myChannelEpg;
-  }
+  std::string lowerCaseId = id;
+  StringUtils::ToLower(lowerCaseId);
+
+  auto channelEpgIndexPair = m_channelEpgIndexesById.find(lowerCaseId);
+  if (channelEpgIndexPair != m_channelEpgIndexesById.end())
+    return &m_channelEpgs.at(channelEpgIndexPair->second);
 
   return nullptr;
 }
 
 ChannelEpg* Epg::FindEpgForChannel(const Channel& channel)
 {
-  for (auto& myChannelEpg : m_channelEpgs)
+  // The first XMLTV channel matching on any of the keys wins, as the matches
+  // come from separate indexes that is the one with the lowest index
+  size_t foundIndex = m_channelEpgs.size();
+
+  // The id index is without case but the tvg-id has to match exactly
+  const ChannelEpg* channelEpg = FindEpgForChannel(channel.GetTvgId());
+  if (channelEpg && channelEpg->GetId() == channel.GetTvgId())
+    foundIndex = channelEpg - m_channelEpgs.data();
+
+  auto findIndex = [&foundIndex](const std::unordered_map<std::string, size_t>& channelEpgIndexes, const std::string& key)
   {
-    if (myChannelEpg.GetId() == channel.GetTvgId())
-      return &myChannelEpg;
+    auto channelEpgIndexPair = channelEpgIndexes.find(key);
+    if (channelEpgIndexPair != channelEpgIndexes.end())
+      foundIndex = std::min(foundIndex, channelEpgIndexPair->second);
+  };
 
-    const std::string name = std::regex_replace(myChannelEpg.GetName(), std::regex(" "), "_");
-    if (name == channel.GetTvgName() || myChannelEpg.GetName() == channel.GetTvgName())
-      return &myChannelEpg;
+  findIndex(m_channelEpgIndexesByTvgName, channel.GetTvgName());
+  findIndex(m_channelEpgIndexesByName, channel.GetTvgName());
+  findIndex(m_channelEpgIndexesByName, channel.GetChannelName());
 
-    if (myChannelEpg.GetName() == channel.GetChannelName())
-      return &myChannelEpg;
-  }
+  if (foundIndex < m_channelEpgs.size())
+    return &m_channelEpgs[foundIndex];
 
   return nullptr;
 }
 
+size_t Epg::GetMemoryUsage() const
+{
+  size_t size = MemoryUtils::GetHeapSize(m_channelEpgs) + MemoryUtils::GetHeapSize(m_channelEpgIndexesById) +
+                MemoryUtils::GetHeapSize(m_channelEpgIndexesByName) + MemoryUtils::GetHeapSize(m_channelEpgIndexesByTvgName) +
+                MemoryUtils::GetHeapSize(m_genres);
+
+  for (const auto& channelEpg : m_channelEpgs)
+    size += channelEpg.GetMemoryUsage();
+
+  return size;
+}
+
 void Epg::ApplyChannelsLogosFromEPG()
 {
+  ScopedTraceSpan span("Epg::ApplyChannelsLogosFromEPG");
+
   bool updated = false;
 
   for (const auto& channel : m_channels.GetChannelsList())
@@ -364,9 +576,10 @@ void Epg::ApplyChannelsLogosFromEPG()
       continue;
 
     // 2 - prefer logo from epg
-    if (!channelEpg->GetIcon().empty() && Settings::GetInstance().GetEpgLogosMode() == EpgLogosMode::PREFER_XMLTV)
+    if (!channelEpg->GetIcon().empty() && Settings::GetInstance().GetEpgLogosMode() == EpgLogosMode::PREFER_XMLTV &&
+        channel.GetLogoPath() != channelEpg->GetIcon())
     {
-      m_channels.GetChannel(channel.GetUniqueId())->SetLogoPath(channelEpg->GetIcon());
+      m_channels.SetChannelLogoPath(channel.GetUniqueId(), channelEpg->GetIcon());
       updated = true;
     }
   }
@@ -375,7 +588,7 @@ void Epg::ApplyChannelsLogosFromEPG()
     PVR->TriggerChannelUpdate();
 }
 
-bool Epg::LoadGenres()
+bool Epg::LoadGenres(std::vector<EpgGenre>& genres)
 {
   // try to load genres from userdata folder
   std::string filePath = FileUtils::GetUserFilePath(GENRES_MAP_FILENAME);
@@ -393,7 +606,7 @@ bool Epg::LoadGenres()
   if (data.empty())
     return false;
 
-  m_genres.clear();
+  genres.clear();
 
   char* buffer = &(data[0]);
   xml_document<> xmlDoc;
@@ -415,7 +628,7 @@ bool Epg::LoadGenres()
     EpgGenre genre;
 
     if (genre.UpdateFrom(pGenreNode))
-      m_genres.emplace_back(genre);
+      genres.emplace_back(genre);
   }
 
   xmlDoc.clear();
@@ -22,17 +22,27 @@
  */
 
 #include "kodi/libXBMC_pvr.h"
+#include "p8-platform/threads/mutex.h"
 
 #include "Channels.h"
 #include "data/ChannelEpg.h"
 #include "data/EpgGenre.h"
+#include "utilities/CancellationToken.h"
 
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace iptvsimple
 {
   static const int SECONDS_IN_DAY = 86400;
+  // Window loaded when the EPG is loaded before Kodi asks for it, Kodi's own window is usually within it
+  static const int EPG_DEFAULT_PAST_DAYS = 1;
+  static const int EPG_DEFAULT_FUTURE_DAYS = 7;
+  // Extra time loaded past the end of the window requested so moving the window a little doesn't reload
+  static const int EPG_WINDOW_SLACK_SECS = SECONDS_IN_DAY;
   static const std::string GENRES_MAP_FILENAME = "genres.xml";
 
   enum class XmltvFileFormat
@@ -42,37 +52,79 @@ namespace iptvsimple
     INVALID
   };
 
+  /**
+   * A fetched and parsed XMLTV file that has not been bound to the channels yet.
+   * The document is parsed in place so it has to stay with its data.
+   */
+  struct XmltvDocument
+  {
+    ~XmltvDocument();
+
+    std::string data;
+    rapidxml::xml_document<> document;
+    rapidxml::xml_node<>* rootElement = nullptr;
+  };
+
   class Epg
   {
   public:
-    Epg(iptvsimple::Channels& channels);
+    Epg(iptvsimple::Channels& channels, const iptvsimple::utilities::CancellationToken& cancellationToken);
 
     PVR_ERROR GetEPGForChannel(ADDON_HANDLE handle, int iChannelUid, time_t start, time_t end);
     void Clear();
-    void ReloadEPG();
+    void ReloadEPG(P8PLATFORM::CMutex& mutex);
+    bool LastLoadFailed() const { return m_lastLoadFailed; }
+    /**
+     * True when a window that isn't loaded has been requested, RefreshEPG() loads it
+     */
+    bool RefreshPending() const { return m_refreshPending; }
+    bool RefreshEPG(P8PLATFORM::CMutex& mutex);
+    std::unique_ptr<XmltvDocument> FetchXMLTV() const;
+    bool BindEPG(const XmltvDocument& xmltvDocument, P8PLATFORM::CMutex& mutex);
+    void SetGenres(std::vector<iptvsimple::data::EpgGenre>&& genres) { m_genres = std::move(genres); }
+    static bool LoadGenres(std::vector<iptvsimple::data::EpgGenre>& genres);
+    void SetFetchInProgress(bool value) { m_fetchInProgress = value; }
+    void TriggerEpgUpdates();
+    void ApplyTimeshiftSettings();
+    void ApplyChannelsLogosFromEPG();
+    /**
+     * Estimate of the heap memory held by the loaded EPG
+     */
+    size_t GetMemoryUsage() const;
 
   private:
+    // The microbenchmarks in tools/benchmarks call the private hot paths through this
+    friend class BenchmarkAccess;
+
     static const XmltvFileFormat GetXMLTVFileFormat(const char* buffer);
 
-    bool LoadEPG(time_t iStart, time_t iEnd);
-    bool GetXMLTVFileWithRetries(std::string& data);
-    char* FillBufferFromXMLTVData(std::string& data);
+    bool LoadEPGFromDocument(rapidxml::xml_node<>* rootElement, int start, int end, Epg& loadedEpg) const;
+    void PublishLoadedEPG(Epg& loadedEpg);
+    bool GetXMLTVFile(std::string& data) const;
+    char* FillBufferFromXMLTVData(std::string& data) const;
     bool LoadChannelEpgs(rapidxml::xml_node<>* rootElement);
     void LoadEpgEntries(rapidxml::xml_node<>* rootElement, int start, int end);
-    bool LoadGenres();
 
+    void ClearChannelEpgs();
     data::ChannelEpg* FindEpgForChannel(const std::string& id);
     data::ChannelEpg* FindEpgForChannel(const data::Channel& channel);
-    void ApplyChannelsLogosFromEPG();
 
     std::string m_xmltvLocation;
     int m_epgTimeShift;
     bool m_tsOverride;
     int m_lastStart;
     int m_lastEnd;
+    bool m_lastLoadFailed = false;
+    bool m_fetchInProgress = false;
+    bool m_refreshPending = false;
 
     iptvsimple::Channels& m_channels;
+    const iptvsimple::utilities::CancellationToken& m_cancellationToken;
     std::vector<data::ChannelEpg> m_channelEpgs;
+    std::unordered_map<std::string, size_t> m_channelEpgIndexesById;
+    std::unordered_map<std::string, size_t> m_channelEpgIndexesByName;
+    // Display names with the spaces replaced by underscores, as they are written in tvg-name
+    std::unordered_map<std::string, size_t> m_channelEpgIndexesByTvgName;
     std::vector<iptvsimple::data::EpgGenre> m_genres;
   };
 } //namespace iptvsimple
\ No newline at end of file
@@ -22,10 +22,14 @@
 
 #include "PlaylistLoader.h"
 
+#include "PlaylistSnapshot.h"
 #include "Settings.h"
 #include "../client.h"
 #include "utilities/FileUtils.h"
+#include "utilities/HashUtils.h"
 #include "utilities/Logger.h"
+#include "utilities/Metrics.h"
+#include "utilities/Tracer.h"
 
 #include "p8-platform/util/StringUtils.h"
 
@@ -33,129 +37,274 @@
 #include <map>
 #include <regex>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
 using namespace iptvsimple::utilities;
 
-PlaylistLoader::PlaylistLoader(Channels& channels, ChannelGroups& channelGroups)
-  : m_channels(channels), m_channelGroups(channelGroups), m_m3uLocation(Settings::GetInstance().GetM3ULocation()) {}
+namespace
+{
+
+// Kodi allocates the converted string for us, it has to be freed once copied
+std::string UnknownToUTF8(const std::string& value)
+{
+  char* converted = XBMC->UnknownToUTF8(value.c_str());
+  if (!converted)
+    return value;
+
+  const std::string result = converted;
+  XBMC->FreeString(converted);
+  return result;
+}
+
+} // unnamed namespace
+
+PlaylistLoader::PlaylistLoader(Channels& channels, ChannelGroups& channelGroups, P8PLATFORM::CMutex& mutex,
+                               const CancellationToken& cancellationToken)
+  : m_m3uLocation(Settings::GetInstance().GetM3ULocation()), m_channelGroups(channelGroups), m_channels(channels),
+    m_mutex(mutex), m_cancellationToken(cancellationToken) {}
 
 bool PlaylistLoader::LoadPlayList()
 {
-  if (m_m3uLocation.empty())
-  {
-    Logger::Log(LEVEL_NOTICE, "Playlist file path is not configured. Channels not loaded.");
+  if (!LoadPlayList(m_channels, m_channelGroups, true))
     return false;
-  }
 
-  std::string playlistContent;
-  if (!FileUtils::GetCachedFileContents(M3U_FILE_NAME, m_m3uLocation, playlistContent, Settings::GetInstance().UseM3UCache()))
+  if (PlaylistSnapshot::IsSaved(m_m3uLocation, m_contentHash))
+    return true;
+
+  std::string snapshot;
   {
-    Logger::Log(LEVEL_ERROR, "Unable to load playlist file '%s':  file is missing or empty.", m_m3uLocation.c_str());
-    return false;
+    TimedLockObject lock(m_mutex);
+    snapshot = PlaylistSnapshot::Serialise(m_m3uLocation, m_channels, m_channelGroups, m_contentHash);
   }
+  PlaylistSnapshot::Write(snapshot);
 
-  std::stringstream stream(playlistContent);
+  return true;
+}
+
+bool PlaylistLoader::LoadPlayListSnapshot()
+{
+  TimedLockObject lock(m_mutex);
+  return PlaylistSnapshot::Load(m_m3uLocation, m_channels, m_channelGroups, m_contentHash);
+}
 
-  /* load channels */
-  bool isFirstLine = true;
-  bool isRealTime = true;
-  int epgTimeShift = 0;
-  std::vector<int> currentChannelGroupIdList;
+bool PlaylistLoader::LoadPlayList(Channels& channels, ChannelGroups& channelGroups, bool publishProgressively)
+{
+  ScopedTraceSpan span("PlaylistLoader::LoadPlayList");
 
-  Channel tmpChannel;
+  if (m_m3uLocation.empty())
+  {
+    Logger::Log(LEVEL_NOTICE, "Playlist file path is not configured. Channels not loaded.");
+    return false;
+  }
 
+  ParseState state(channels, channelGroups);
+  std::string pendingData;
   std::string line;
-  while (std::getline(stream, line))
+  uint64_t contentHash = HashUtils::FNV_OFFSET_BASIS;
+
+  m_channelsAmountAtLastTrigger = 0;
+  m_lastTriggerTime = std::chrono::steady_clock::time_point();
+
+  // Parse complete lines as the data arrives. When publishing progressively the channels found
+  // are added in batches, holding the lock only while a batch is added so Kodi can read what is
+  // already loaded.
+  const int bytesRead = FileUtils::StreamCachedFileContents(M3U_FILE_NAME, m_m3uLocation, [&](const char* data, size_t length)
   {
-    line = StringUtils::TrimRight(line, " \t\r\n");
-    line = StringUtils::TrimLeft(line, " \t");
+    contentHash = HashUtils::Fnv1aHash(data, length, contentHash);
+    pendingData.append(data, length);
 
-    Logger::Log(LEVEL_DEBUG, "Read line: '%s'", line.c_str());
+    const size_t lastLineEnd = pendingData.rfind('\n');
+    if (lastLineEnd == std::string::npos)
+      return;
 
-    if (line.empty())
-      continue;
+    if (publishProgressively)
+    {
+      {
+        TimedLockObject lock(m_mutex);
+        ParseLines(pendingData, lastLineEnd, line, state);
+      }
 
-    if (isFirstLine)
+      TriggerChannelUpdatesIfDue(false);
+    }
+    else
     {
-      isFirstLine = false;
+      ParseLines(pendingData, lastLineEnd, line, state);
+    }
 
-      if (StringUtils::Left(line, 3) == "\xEF\xBB\xBF")
-        line.erase(0, 3);
+    pendingData.erase(0, lastLineEnd + 1);
+  }, Settings::GetInstance().UseM3UCache(), FileUtils::CreateFetchOptions(m_cancellationToken, "playlist"));
 
-      if (StringUtils::StartsWith(line, M3U_START_MARKER)) //#EXTM3U
+  if (bytesRead == 0)
+  {
+    Logger::Log(LEVEL_ERROR, "Unable to load playlist file '%s':  file is missing or empty.", m_m3uLocation.c_str());
+
+    // A fetch that fails part way has already published some of the channels. A progressive
+    // load always starts from no channels so that is restored rather than leaving Kodi with a
+    // truncated list, the update thread tries the load again later.
+    if (publishProgressively)
+    {
       {
-        double tvgShiftDecimal = std::atof(ReadMarkerValue(line, TVG_INFO_SHIFT_MARKER).c_str());
-        epgTimeShift = static_cast<int>(tvgShiftDecimal * 3600.0);
-        continue;
+        TimedLockObject lock(m_mutex);
+        channels.Clear();
+        channelGroups.Clear();
       }
-      else
+
+      // Kodi doesn't need telling when it is stopping the addon
+      if (m_channelsAmountAtLastTrigger > 0 && !m_cancellationToken.IsCancelled())
       {
-        Logger::Log(LEVEL_ERROR, "URL '%s' missing %s descriptor on line 1, attempting to parse it anyway.",
-                    m_m3uLocation.c_str(), M3U_START_MARKER.c_str());
+        m_channelsAmountAtLastTrigger = 0;
+        PVR->TriggerChannelUpdate();
+        PVR->TriggerChannelGroupsUpdate();
       }
     }
 
-    if (StringUtils::StartsWith(line, M3U_INFO_MARKER)) //#EXTINF
-    {
-      tmpChannel.SetChannelNumber(m_channels.GetCurrentChannelNumber());
-      currentChannelGroupIdList.clear();
+    return false;
+  }
 
-      const std::string groupNamesListString = ParseIntoChannel(line, tmpChannel, currentChannelGroupIdList, epgTimeShift);
+  // the last line may not have a line ending
+  if (!pendingData.empty())
+  {
+    TimedLockObject lock(m_mutex);
+    ParseLine(pendingData, state);
+  }
 
-      if (!groupNamesListString.empty())
-        ParseAndAddChannelGroups(groupNamesListString, currentChannelGroupIdList, tmpChannel.IsRadio());
-    }
-    else if (StringUtils::StartsWith(line, KODIPROP_MARKER)) //#KODIPROP:
-    {
-      ParseSinglePropertyIntoChannel(line, tmpChannel, KODIPROP_MARKER);
-    }
-    else if (StringUtils::StartsWith(line, EXTVLCOPT_MARKER)) //#EXTVLCOPT:
-    {
-      ParseSinglePropertyIntoChannel(line, tmpChannel, EXTVLCOPT_MARKER);
-    }
-    else if (StringUtils::StartsWith(line, M3U_GROUP_MARKER)) //#EXTGRP:
+  if (publishProgressively)
+    TriggerChannelUpdatesIfDue(true);
+
+  TimedLockObject lock(m_mutex);
+
+  if (channels.GetChannelsAmount() == 0)
+  {
+    Logger::Log(LEVEL_ERROR, "Unable to load channels from file '%s':  file is corrupted.", m_m3uLocation.c_str());
+    return false;
+  }
+
+  m_contentHash = contentHash;
+
+  Logger::Log(LEVEL_NOTICE, "Loaded %d channels.", channels.GetChannelsAmount());
+  return true;
+}
+
+void PlaylistLoader::ParseLines(const std::string& data, size_t dataEnd, std::string& line, ParseState& state)
+{
+  size_t lineStart = 0;
+  while (lineStart <= dataEnd)
+  {
+    size_t lineEnd = data.find('\n', lineStart);
+    if (lineEnd == std::string::npos)
+      lineEnd = data.length();
+
+    line.assign(data, lineStart, lineEnd - lineStart);
+    ParseLine(line, state);
+    lineStart = lineEnd + 1;
+  }
+}
+
+void PlaylistLoader::ParseLine(std::string& line, ParseState& state)
+{
+  line = StringUtils::TrimRight(line, " \t\r\n");
+  line = StringUtils::TrimLeft(line, " \t");
+
+  Logger::Log(LEVEL_DEBUG, "Read line: '%s'", line.c_str());
+
+  if (line.empty())
+    return;
+
+  if (state.isFirstLine)
+  {
+    state.isFirstLine = false;
+
+    if (StringUtils::Left(line, 3) == "\xEF\xBB\xBF")
+      line.erase(0, 3);
+
+    if (StringUtils::StartsWith(line, M3U_START_MARKER)) //#EXTM3U
     {
-      const std::string groupNamesListString = ReadMarkerValue(line, M3U_GROUP_MARKER);
-      if (!groupNamesListString.empty())
-        ParseAndAddChannelGroups(groupNamesListString, currentChannelGroupIdList, tmpChannel.IsRadio());
+      double tvgShiftDecimal = std::atof(ReadMarkerValue(line, TVG_INFO_SHIFT_MARKER).c_str());
+      state.epgTimeShift = static_cast<int>(tvgShiftDecimal * 3600.0);
+      return;
     }
-    else if (StringUtils::StartsWith(line, PLAYLIST_TYPE_MARKER)) //#EXT-X-PLAYLIST-TYPE:
+    else
     {
-      if (ReadMarkerValue(line, PLAYLIST_TYPE_MARKER) == "VOD")
-        isRealTime = false;
+      Logger::Log(LEVEL_ERROR, "URL '%s' missing %s descriptor on line 1, attempting to parse it anyway.",
+                  m_m3uLocation.c_str(), M3U_START_MARKER.c_str());
     }
-    else if (line[0] != '#')
-    {
-      Logger::Log(LEVEL_DEBUG, "Found URL: '%s' (current channel name: '%s')", line.c_str(), tmpChannel.GetChannelName().c_str());
+  }
 
-      if (isRealTime)
-        tmpChannel.AddProperty(PVR_STREAM_PROPERTY_ISREALTIMESTREAM, "true");
+  Channel& tmpChannel = state.tmpChannel;
 
-      Channel channel(tmpChannel);
-      channel.SetStreamURL(line);
+  if (StringUtils::StartsWith(line, M3U_INFO_MARKER)) //#EXTINF
+  {
+    tmpChannel.SetChannelNumber(state.channels.GetCurrentChannelNumber());
+    state.currentChannelGroupIdList.clear();
 
-      m_channels.AddChannel(channel, currentChannelGroupIdList, m_channelGroups);
+    const std::string groupNamesListString = ParseIntoChannel(line, tmpChannel, state.currentChannelGroupIdList, state.epgTimeShift);
 
-      tmpChannel.Reset();
-      isRealTime = true;
-    }
+    if (!groupNamesListString.empty())
+      ParseAndAddChannelGroups(groupNamesListString, state.channelGroups, state.currentChannelGroupIdList, tmpChannel.IsRadio());
+  }
+  else if (StringUtils::StartsWith(line, KODIPROP_MARKER)) //#KODIPROP:
+  {
+    ParseSinglePropertyIntoChannel(line, tmpChannel, KODIPROP_MARKER);
+  }
+  else if (StringUtils::StartsWith(line, EXTVLCOPT_MARKER)) //#EXTVLCOPT:
+  {
+    ParseSinglePropertyIntoChannel(line, tmpChannel, EXTVLCOPT_MARKER);
   }
+  else if (StringUtils::StartsWith(line, M3U_GROUP_MARKER)) //#EXTGRP:
+  {
+    const std::string groupNamesListString = ReadMarkerValue(line, M3U_GROUP_MARKER);
+    if (!groupNamesListString.empty())
+      ParseAndAddChannelGroups(groupNamesListString, state.channelGroups, state.currentChannelGroupIdList, tmpChannel.IsRadio());
+  }
+  else if (StringUtils::StartsWith(line, PLAYLIST_TYPE_MARKER)) //#EXT-X-PLAYLIST-TYPE:
+  {
+    if (ReadMarkerValue(line, PLAYLIST_TYPE_MARKER) == "VOD")
+      state.isRealTime = false;
+  }
+  else if (line[0] != '#')
+  {
+    Logger::Log(LEVEL_DEBUG, "Found URL: '%s' (current channel name: '%s')", line.c_str(), tmpChannel.GetChannelName().c_str());
 
-  stream.clear();
+    if (state.isRealTime)
+      tmpChannel.AddProperty(PVR_STREAM_PROPERTY_ISREALTIMESTREAM, "true");
 
-  if (m_channels.GetChannelsAmount() == 0)
+    tmpChannel.SetStreamURL(std::move(line));
+
+    state.channels.AddChannel(std::move(tmpChannel), state.currentChannelGroupIdList, state.channelGroups);
+
+    tmpChannel.Reset();
+    state.isRealTime = true;
+  }
+}
+
+void PlaylistLoader::TriggerChannelUpdatesIfDue(bool force)
+{
+  int channelsAmount;
   {
-    Logger::Log(LEVEL_ERROR, "Unable to load channels from file '%s':  file is corrupted.", m_m3uLocation.c_str());
-    return false;
+    TimedLockObject lock(m_mutex);
+    channelsAmount = m_channels.GetChannelsAmount();
   }
 
-  m_channels.ApplyChannelLogos();
+  if (channelsAmount == m_channelsAmountAtLastTrigger)
+    return;
 
-  Logger::Log(LEVEL_NOTICE, "Loaded %d channels.", m_channels.GetChannelsAmount());
-  return true;
+  // The first batch is signalled straight away, after that Kodi is only asked
+  // to resync once per interval as each sync transfers the full channel list.
+  const auto now = std::chrono::steady_clock::now();
+  if (!force && m_channelsAmountAtLastTrigger > 0 &&
+      now - m_lastTriggerTime < std::chrono::seconds(CHANNEL_UPDATE_TRIGGER_INTERVAL_SECS))
+    return;
+
+  Logger::Log(LEVEL_DEBUG, "%s - Publishing %d channels", __FUNCTION__, channelsAmount);
+
+  m_channelsAmountAtLastTrigger = channelsAmount;
+  m_lastTriggerTime = now;
+
+  PVR->TriggerChannelUpdate();
+  PVR->TriggerChannelGroupsUpdate();
 }
 
 std::string PlaylistLoader::ParseIntoChannel(const std::string& line, Channel& channel, std::vector<int>& groupIdList, int epgTimeShift)
@@ -168,7 +317,7 @@ std::string PlaylistLoader::ParseIntoChannel(const std::string& line, Channel& c
     // parse name
     std::string channelName = line.substr(commaIndex + 1);
     channelName = StringUtils::Trim(channelName);
-    channel.SetChannelName(XBMC->UnknownToUTF8(channelName.c_str()));
+    channel.SetChannelName(UnknownToUTF8(channelName));
 
     // parse info line containng the attributes for a channel
     const std::string infoLine = line.substr(colonIndex + 1, commaIndex - colonIndex - 1);
@@ -196,9 +345,9 @@ std::string PlaylistLoader::ParseIntoChannel(const std::string& line, Channel& c
     double tvgShiftDecimal = std::atof(strTvgShift.c_str());
 
     bool isRadio = !StringUtils::CompareNoCase(strRadio, "true");
-    channel.SetTvgId(strTvgId);
-    channel.SetTvgName(XBMC->UnknownToUTF8(strTvgName.c_str()));
-    channel.SetTvgLogo(XBMC->UnknownToUTF8(strTvgLogo.c_str()));
+    channel.SetTvgId(std::move(strTvgId));
+    channel.SetTvgName(UnknownToUTF8(strTvgName));
+    channel.SetTvgLogo(UnknownToUTF8(strTvgLogo));
     channel.SetTvgShift(static_cast<int>(tvgShiftDecimal * 3600.0));
     channel.SetRadio(isRadio);
 
@@ -211,7 +360,7 @@ std::string PlaylistLoader::ParseIntoChannel(const std::string& line, Channel& c
   return "";
 }
 
-void PlaylistLoader::ParseAndAddChannelGroups(const std::string& groupNamesListString, std::vector<int>& groupIdList, bool isRadio)
+void PlaylistLoader::ParseAndAddChannelGroups(const std::string& groupNamesListString, ChannelGroups& channelGroups, std::vector<int>& groupIdList, bool isRadio)
 {
   //groupNamesListString may have a single or multiple group names seapareted by ';'
 
@@ -220,13 +369,13 @@ void PlaylistLoader::ParseAndAddChannelGroups(const std::string& groupNamesListS
 
   while (std::getline(streamGroups, groupName, ';'))
   {
-    groupName = XBMC->UnknownToUTF8(groupName.c_str());
+    groupName = UnknownToUTF8(groupName);
 
     ChannelGroup group;
     group.SetGroupName(groupName);
     group.SetRadio(isRadio);
 
-    int uniqueGroupId = m_channelGroups.AddChannelGroup(group);
+    int uniqueGroupId = channelGroups.AddChannelGroup(group);
     groupIdList.emplace_back(uniqueGroupId);
   }
 }
@@ -237,26 +386,155 @@ void PlaylistLoader::ParseSinglePropertyIntoChannel(const std::string& line, Cha
   auto pos = value.find('=');
   if (pos != std::string::npos)
   {
-    const std::string prop = value.substr(0, pos);
-    const std::string propValue = value.substr(pos + 1);
-    channel.AddProperty(prop, propValue);
+    std::string prop = value.substr(0, pos);
+    std::string propValue = value.substr(pos + 1);
 
     Logger::Log(LEVEL_DEBUG, "%s - Found %s property: '%s' value: '%s'", __FUNCTION__, markerName.c_str(), prop.c_str(), propValue.c_str());
+
+    channel.AddProperty(std::move(prop), std::move(propValue));
   }
 }
 
-void PlaylistLoader::ReloadPlayList()
+bool PlaylistLoader::ReloadPlayList(bool& epgChannelsChanged)
 {
   m_m3uLocation = Settings::GetInstance().GetM3ULocation();
 
-  m_channels.Clear();
-  m_channelGroups.Clear();
+  // Load into new lists which are then diffed against the current lists
+  // so Kodi is only asked to resync what has actually changed.
+  Channels newChannels;
+  ChannelGroups newChannelGroups{newChannels};
 
-  if (LoadPlayList())
+  // Keep what is already loaded, e.g. from the snapshot, if the playlist can't be fetched.
+  // An empty location still clears the channels as that is what has been configured.
+  if (!LoadPlayList(newChannels, newChannelGroups, false) && !m_m3uLocation.empty())
+    return false;
+
+  if (!m_m3uLocation.empty())
+    PlaylistSnapshot::Save(m_m3uLocation, newChannels, newChannelGroups, m_contentHash);
+
+  bool channelsChanged = false;
+  bool channelGroupsChanged = false;
   {
+    TimedLockObject lock(m_mutex);
+    PublishReloadedPlayList(newChannels, newChannelGroups, channelsChanged, channelGroupsChanged, epgChannelsChanged);
+  }
+
+  if (channelsChanged)
     PVR->TriggerChannelUpdate();
+  if (channelGroupsChanged)
     PVR->TriggerChannelGroupsUpdate();
+
+  return true;
+}
+
+namespace
+{
+
+bool KodiChannelFieldsMatch(const Channel& left, const Channel& right)
+{
+  return left.GetChannelNumber() == right.GetChannelNumber() &&
+         left.IsRadio() == right.IsRadio() &&
+         left.GetEncryptionSystem() == right.GetEncryptionSystem() &&
+         left.GetChannelName() == right.GetChannelName() &&
+         left.GetLogoPath() == right.GetLogoPath();
+}
+
+bool EpgChannelFieldsMatch(const Channel& left, const Channel& right)
+{
+  return left.GetTvgId() == right.GetTvgId() &&
+         left.GetTvgName() == right.GetTvgName() &&
+         left.GetChannelName() == right.GetChannelName() &&
+         left.GetTvgShift() == right.GetTvgShift();
+}
+
+std::vector<int> GetMemberChannelUniqueIds(const ChannelGroup& channelGroup, const Channels& channels)
+{
+  std::vector<int> memberUniqueIds;
+  memberUniqueIds.reserve(channelGroup.GetMemberChannelIndexes().size());
+
+  for (int memberIndex : channelGroup.GetMemberChannelIndexes())
+  {
+    if (memberIndex >= 0 && memberIndex < channels.GetChannelsAmount())
+      memberUniqueIds.emplace_back(channels.GetChannelUniqueIds()[memberIndex]);
   }
+
+  return memberUniqueIds;
+}
+
+} // unnamed namespace
+
+void PlaylistLoader::PublishReloadedPlayList(Channels& newChannels, ChannelGroups& newChannelGroups,
+                                             bool& channelsChanged, bool& channelGroupsChanged, bool& epgChannelsChanged)
+{
+  int addedChannels = 0;
+  int changedChannels = 0;
+  int removedChannels = 0;
+  int epgChangedChannels = 0;
+
+  const bool sameLogoLocation = m_channels.GetLogoLocation() == newChannels.GetLogoLocation();
+
+  for (const auto& newChannel : newChannels.GetChannelsList())
+  {
+    const Channel* currentChannel = m_channels.GetChannel(newChannel.GetUniqueId());
+    if (!currentChannel)
+    {
+      addedChannels++;
+      continue;
+    }
+
+    // Keep any logo applied from the EPG until the EPG is reloaded, otherwise every
+    // reload would look like a logo change when the XMLTV logos are preferred.
+    if (sameLogoLocation && currentChannel->GetTvgLogo() == newChannel.GetTvgLogo())
+      newChannels.SetChannelLogoPath(newChannel.GetUniqueId(), currentChannel->GetLogoPath());
+
+    if (!KodiChannelFieldsMatch(*currentChannel, newChannel))
+      changedChannels++;
+    if (!EpgChannelFieldsMatch(*currentChannel, newChannel))
+      epgChangedChannels++;
+  }
+
+  for (int currentChannelUniqueId : m_channels.GetChannelUniqueIds())
+  {
+    if (!newChannels.GetChannel(currentChannelUniqueId))
+      removedChannels++;
+  }
+
+  int addedChannelGroups = 0;
+  int changedChannelGroups = 0;
+  int removedChannelGroups = 0;
+
+  for (const auto& newChannelGroup : newChannelGroups.GetChannelGroupsList())
+  {
+    const ChannelGroup* currentChannelGroup = m_channelGroups.FindChannelGroup(newChannelGroup.GetGroupName());
+    if (!currentChannelGroup)
+    {
+      addedChannelGroups++;
+      continue;
+    }
+
+    if (currentChannelGroup->IsRadio() != newChannelGroup.IsRadio() ||
+        GetMemberChannelUniqueIds(*currentChannelGroup, m_channels) != GetMemberChannelUniqueIds(newChannelGroup, newChannels))
+      changedChannelGroups++;
+  }
+
+  for (const auto& currentChannelGroup : m_channelGroups.GetChannelGroupsList())
+  {
+    if (!newChannelGroups.FindChannelGroup(currentChannelGroup.GetGroupName()))
+      removedChannelGroups++;
+  }
+
+  channelsChanged = addedChannels > 0 || changedChannels > 0 || removedChannels > 0;
+  channelGroupsChanged = addedChannelGroups > 0 || changedChannelGroups > 0 || removedChannelGroups > 0;
+  // The EPG only keeps the XMLTV channels that matched a channel when it was loaded
+  epgChannelsChanged = addedChannels > 0 || epgChangedChannels > 0;
+
+  Logger::Log(LEVEL_NOTICE, "%s - Channels: %d added, %d changed, %d removed, %d total. Channel groups: %d added, %d changed, %d removed, %d total.",
+              __FUNCTION__, addedChannels, changedChannels, removedChannels, newChannels.GetChannelsAmount(),
+              addedChannelGroups, changedChannelGroups, removedChannelGroups, newChannelGroups.GetChannelGroupsAmount());
+
+  // The member indexes of the groups stay valid as the channels are swapped as a whole
+  std::swap(m_channels, newChannels);
+  m_channelGroups.Swap(newChannelGroups);
 }
 
 std::string PlaylistLoader::ReadMarkerValue(const std::string& line, const std::string& markerName)
@@ -22,11 +22,16 @@
  */
 
 #include "kodi/libXBMC_pvr.h"
+#include "p8-platform/threads/mutex.h"
 
 #include "Channels.h"
 #include "ChannelGroups.h"
+#include "utilities/CancellationToken.h"
 
+#include <chrono>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace iptvsimple
 {
@@ -45,24 +50,58 @@ namespace iptvsimple
   static const std::string PLAYLIST_TYPE_MARKER    = "#EXT-X-PLAYLIST-TYPE:";
   static const std::string CHANNEL_LOGO_EXTENSION  = ".png";
 
+  static const int CHANNEL_UPDATE_TRIGGER_INTERVAL_SECS = 5;
+
   class PlaylistLoader
   {
   public:
-    PlaylistLoader(iptvsimple::Channels& channels, iptvsimple::ChannelGroups& channelGroups);
+    PlaylistLoader(iptvsimple::Channels& channels, iptvsimple::ChannelGroups& channelGroups, P8PLATFORM::CMutex& mutex,
+                   const iptvsimple::utilities::CancellationToken& cancellationToken);
 
     bool LoadPlayList();
-    void ReloadPlayList();
+    bool LoadPlayListSnapshot();
+    bool ReloadPlayList(bool& epgChannelsChanged);
 
   private:
+    // The microbenchmarks in tools/benchmarks call the private hot paths through this
+    friend class BenchmarkAccess;
+
+    struct ParseState
+    {
+      ParseState(iptvsimple::Channels& channels, iptvsimple::ChannelGroups& channelGroups)
+        : channels(channels), channelGroups(channelGroups) {}
+
+      iptvsimple::Channels& channels;
+      iptvsimple::ChannelGroups& channelGroups;
+      bool isFirstLine = true;
+      bool isRealTime = true;
+      int epgTimeShift = 0;
+      std::vector<int> currentChannelGroupIdList;
+      iptvsimple::data::Channel tmpChannel;
+    };
+
+    bool LoadPlayList(iptvsimple::Channels& channels, iptvsimple::ChannelGroups& channelGroups, bool publishProgressively);
+    void ParseLines(const std::string& data, size_t dataEnd, std::string& line, ParseState& state);
+    void ParseLine(std::string& line, ParseState& state);
+    void TriggerChannelUpdatesIfDue(bool force);
+    void PublishReloadedPlayList(iptvsimple::Channels& newChannels, iptvsimple::ChannelGroups& newChannelGroups,
+                                 bool& channelsChanged, bool& channelGroupsChanged, bool& epgChannelsChanged);
+
     static std::string ReadMarkerValue(const std::string& line, const std::string& markerName);
     static void ParseSinglePropertyIntoChannel(const std::string& line, iptvsimple::data::Channel& channel, const std::string& markerName);
 
     std::string ParseIntoChannel(const std::string& line, iptvsimple::data::Channel& channel, std::vector<int>& groupIdList, int epgTimeShift);
-    void ParseAndAddChannelGroups(const std::string& groupNamesListString, std::vector<int>& groupIdList, bool isRadio);
+    void ParseAndAddChannelGroups(const std::string& groupNamesListString, iptvsimple::ChannelGroups& channelGroups, std::vector<int>& groupIdList, bool isRadio);
 
     std::string m_m3uLocation;
+    uint64_t m_contentHash = 0;
 
     iptvsimple::ChannelGroups& m_channelGroups;
     iptvsimple::Channels& m_channels;
+    P8PLATFORM::CMutex& m_mutex;
+    const iptvsimple::utilities::CancellationToken& m_cancellationToken;
+
+    int m_channelsAmountAtLastTrigger = 0;
+    std::chrono::steady_clock::time_point m_lastTriggerTime;
   };
 } //namespace iptvsimple
\ No newline at end of file
@@ -0,0 +1,443 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "PlaylistSnapshot.h"
+
+#include "Settings.h"
+#include "../client.h"
+#include "utilities/FileUtils.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace iptvsimple;
+using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
+
+namespace
+{
+
+const char SNAPSHOT_MAGIC[] = "IPTVSNAP";
+const size_t SNAPSHOT_MAGIC_LENGTH = sizeof(SNAPSHOT_MAGIC) - 1;
+
+class SnapshotWriter
+{
+public:
+  void WriteInt(int32_t value) { m_data.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+  void WriteUInt(uint32_t value) { m_data.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+  void WriteUInt64(uint64_t value) { m_data.append(reinterpret_cast<const char*>(&value), sizeof(value)); }
+  void WriteBool(bool value) { m_data.push_back(value ? 1 : 0); }
+
+  void WriteString(const std::string& value)
+  {
+    WriteUInt(value.length());
+    m_data.append(value);
+  }
+
+  /**
+   * Strings are written once to the string table and referenced by index
+   */
+  void WriteStringIndex(const std::string& value)
+  {
+    auto stringIndexPair = m_stringIndexes.find(value);
+    if (stringIndexPair == m_stringIndexes.end())
+    {
+      stringIndexPair = m_stringIndexes.insert({value, m_strings.size()}).first;
+      m_strings.emplace_back(&stringIndexPair->first);
+    }
+
+    WriteUInt(stringIndexPair->second);
+  }
+
+  std::string& GetData() { return m_data; }
+  const std::vector<const std::string*>& GetStrings() const { return m_strings; }
+
+private:
+  std::string m_data;
+  std::unordered_map<std::string, uint32_t> m_stringIndexes;
+  std::vector<const std::string*> m_strings;
+};
+
+class SnapshotReader
+{
+public:
+  SnapshotReader(const std::string& data) : m_data(data) {}
+
+  bool ReadInt(int32_t& value) { return Read(&value, sizeof(value)); }
+  bool ReadUInt(uint32_t& value) { return Read(&value, sizeof(value)); }
+  bool ReadUInt64(uint64_t& value) { return Read(&value, sizeof(value)); }
+
+  bool ReadBool(bool& value)
+  {
+    char byte;
+    if (!Read(&byte, sizeof(byte)))
+      return false;
+
+    value = byte != 0;
+    return true;
+  }
+
+  bool ReadString(std::string& value)
+  {
+    uint32_t length;
+    if (!ReadUInt(length) || length > m_data.length() - m_position)
+      return false;
+
+    value.assign(m_data, m_position, length);
+    m_position += length;
+    return true;
+  }
+
+  /**
+   * The string table is kept as offsets into the snapshot data so each
+   * string is only copied once, straight into the channel or group
+   */
+  bool ReadStringTable()
+  {
+    uint32_t count;
+    if (!ReadUInt(count))
+      return false;
+
+    m_stringTable.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      uint32_t length;
+      if (!ReadUInt(length) || length > m_data.length() - m_position)
+        return false;
+
+      m_stringTable.emplace_back(m_position, length);
+      m_position += length;
+    }
+
+    return true;
+  }
+
+  bool ReadStringIndex(std::string& value)
+  {
+    uint32_t index;
+    if (!ReadUInt(index) || index >= m_stringTable.size())
+      return false;
+
+    value.assign(m_data, m_stringTable[index].first, m_stringTable[index].second);
+    return true;
+  }
+
+  void Skip(size_t length) { m_position = std::min(m_position + length, m_data.length()); }
+
+private:
+  bool Read(void* value, size_t length)
+  {
+    if (length > m_data.length() - m_position)
+      return false;
+
+    std::memcpy(value, m_data.data() + m_position, length);
+    m_position += length;
+    return true;
+  }
+
+  const std::string& m_data;
+  size_t m_position = 0;
+  std::vector<std::pair<size_t, size_t>> m_stringTable;
+};
+
+bool ReadChannel(SnapshotReader& reader, Channel& channel)
+{
+  int32_t uniqueId, channelNumber, encryptionSystem, tvgShift;
+  bool radio;
+  if (!reader.ReadInt(uniqueId) || !reader.ReadInt(channelNumber) || !reader.ReadInt(encryptionSystem) ||
+      !reader.ReadInt(tvgShift) || !reader.ReadBool(radio))
+    return false;
+
+  channel.SetUniqueId(uniqueId);
+  channel.SetChannelNumber(channelNumber);
+  channel.SetEncryptionSystem(encryptionSystem);
+  channel.SetTvgShift(tvgShift);
+  channel.SetRadio(radio);
+
+  std::string value;
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetChannelName(std::move(value));
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetLogoPath(std::move(value));
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetStreamURL(std::move(value));
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetTvgId(std::move(value));
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetTvgName(std::move(value));
+  if (!reader.ReadStringIndex(value))
+    return false;
+  channel.SetTvgLogo(std::move(value));
+
+  uint32_t propertyCount;
+  if (!reader.ReadUInt(propertyCount))
+    return false;
+
+  for (uint32_t i = 0; i < propertyCount; i++)
+  {
+    std::string prop;
+    if (!reader.ReadStringIndex(prop) || !reader.ReadStringIndex(value))
+      return false;
+
+    channel.AddProperty(std::move(prop), std::move(value));
+  }
+
+  return true;
+}
+
+bool ReadChannelGroup(SnapshotReader& reader, ChannelGroups& channelGroups, int channelsAmount)
+{
+  ChannelGroup channelGroup;
+  std::string groupName;
+  bool radio;
+  int32_t uniqueId;
+  uint32_t memberCount;
+  if (!reader.ReadStringIndex(groupName) || !reader.ReadBool(radio) || !reader.ReadInt(uniqueId) || !reader.ReadUInt(memberCount))
+    return false;
+
+  channelGroup.SetGroupName(groupName);
+  channelGroup.SetRadio(radio);
+
+  for (uint32_t i = 0; i < memberCount; i++)
+  {
+    int32_t memberIndex;
+    if (!reader.ReadInt(memberIndex) || memberIndex < 0 || memberIndex >= channelsAmount)
+      return false;
+
+    channelGroup.AddMemberChannelIndex(memberIndex);
+  }
+
+  // Groups are added in the order they were saved so they get back the same unique ids
+  return channelGroups.AddChannelGroup(channelGroup) == uniqueId;
+}
+
+} // unnamed namespace
+
+std::string PlaylistSnapshot::CreateHeader(const std::string& m3uLocation, uint64_t contentHash)
+{
+  SnapshotWriter writer;
+
+  writer.GetData().append(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC_LENGTH);
+  writer.WriteUInt(SNAPSHOT_VERSION);
+  writer.WriteUInt64(contentHash);
+
+  // The settings used when parsing the playlist, if any of these change the snapshot is stale
+  writer.WriteString(m3uLocation);
+  writer.WriteString(Settings::GetInstance().GetLogoLocation());
+  writer.WriteInt(Settings::GetInstance().GetStartChannelNumber());
+
+  return writer.GetData();
+}
+
+bool PlaylistSnapshot::Load(const std::string& m3uLocation, Channels& channels, ChannelGroups& channelGroups, uint64_t& contentHash)
+{
+  const std::string snapshotPath = FileUtils::GetUserFilePath(M3U_SNAPSHOT_FILE_NAME);
+  if (m3uLocation.empty() || !XBMC->FileExists(snapshotPath.c_str(), false))
+    return false;
+
+  std::string data;
+  if (FileUtils::GetFileContents(snapshotPath, data) == 0)
+    return false;
+
+  if (data.length() < SNAPSHOT_MAGIC_LENGTH + sizeof(uint32_t) + sizeof(uint64_t) ||
+      data.compare(0, SNAPSHOT_MAGIC_LENGTH, SNAPSHOT_MAGIC) != 0)
+    return false;
+
+  // The content hash is part of the header so read it first to rebuild the expected header
+  uint64_t snapshotContentHash;
+
+  std::memcpy(&snapshotContentHash, data.data() + SNAPSHOT_MAGIC_LENGTH + sizeof(uint32_t), sizeof(snapshotContentHash));
+
+  const std::string header = CreateHeader(m3uLocation, snapshotContentHash);
+  if (data.compare(0, header.length(), header) != 0)
+  {
+    Logger::Log(LEVEL_INFO, "%s - Playlist snapshot is out of date, ignoring it", __FUNCTION__);
+    return false;
+  }
+
+  SnapshotReader reader(data);
+  reader.Skip(header.length());
+
+  uint32_t channelCount;
+  if (!reader.ReadStringTable() || !reader.ReadUInt(channelCount))
+    return false;
+
+  channels.Clear();
+  channelGroups.Clear();
+
+  channels.ReserveChannels(channelCount);
+
+  for (uint32_t i = 0; i < channelCount; i++)
+  {
+    Channel channel;
+    if (!ReadChannel(reader, channel))
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Playlist snapshot is corrupt, ignoring it", __FUNCTION__);
+      channels.Clear();
+      return false;
+    }
+
+    channels.RestoreChannel(std::move(channel));
+  }
+
+  uint32_t groupCount;
+  if (!reader.ReadUInt(groupCount))
+  {
+    channels.Clear();
+    return false;
+  }
+
+  for (uint32_t i = 0; i < groupCount; i++)
+  {
+    if (!ReadChannelGroup(reader, channelGroups, channels.GetChannelsAmount()))
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Playlist snapshot is corrupt, ignoring it", __FUNCTION__);
+      channels.Clear();
+      channelGroups.Clear();
+      return false;
+    }
+  }
+
+  contentHash = snapshotContentHash;
+
+  Logger::Log(LEVEL_NOTICE, "%s - Loaded %d channels and %d channel groups from playlist snapshot", __FUNCTION__,
+              channels.GetChannelsAmount(), channelGroups.GetChannelGroupsAmount());
+  return true;
+}
+
+bool PlaylistSnapshot::IsSaved(const std::string& m3uLocation, uint64_t contentHash)
+{
+  const std::string snapshotPath = FileUtils::GetUserFilePath(M3U_SNAPSHOT_FILE_NAME);
+  if (!XBMC->FileExists(snapshotPath.c_str(), false))
+    return false;
+
+  void* fileHandle = XBMC->OpenFile(snapshotPath.c_str(), 0);
+  if (!fileHandle)
+    return false;
+
+  const std::string header = CreateHeader(m3uLocation, contentHash);
+  std::string existingHeader(header.length(), '\0');
+  const ssize_t bytesRead = XBMC->ReadFile(fileHandle, &existingHeader[0], existingHeader.length());
+  XBMC->CloseFile(fileHandle);
+
+  return bytesRead == static_cast<ssize_t>(header.length()) && existingHeader == header;
+}
+
+std::string PlaylistSnapshot::Serialise(const std::string& m3uLocation, const Channels& channels, const ChannelGroups& channelGroups, uint64_t contentHash)
+{
+  SnapshotWriter body;
+
+  body.WriteUInt(channels.GetChannelsAmount());
+  for (const auto& channel : channels.GetChannelsList())
+  {
+    body.WriteInt(channel.GetUniqueId());
+    body.WriteInt(channel.GetChannelNumber());
+    body.WriteInt(channel.GetEncryptionSystem());
+    body.WriteInt(channel.GetTvgShift());
+    body.WriteBool(channel.IsRadio());
+    body.WriteStringIndex(channel.GetChannelName());
+    body.WriteStringIndex(channel.GetLogoPath());
+    body.WriteStringIndex(channel.GetStreamURL());
+    body.WriteStringIndex(channel.GetTvgId());
+    body.WriteStringIndex(channel.GetTvgName());
+    body.WriteStringIndex(channel.GetTvgLogo());
+
+    body.WriteUInt(channel.GetProperties().size());
+    for (const auto& prop : channel.GetProperties())
+    {
+      body.WriteStringIndex(prop.first);
+      body.WriteStringIndex(prop.second);
+    }
+  }
+
+  body.WriteUInt(channelGroups.GetChannelGroupsAmount());
+  for (const auto& channelGroup : channelGroups.GetChannelGroupsList())
+  {
+    body.WriteStringIndex(channelGroup.GetGroupName());
+    body.WriteBool(channelGroup.IsRadio());
+    body.WriteInt(channelGroup.GetUniqueId());
+
+    body.WriteUInt(channelGroup.GetMemberChannelIndexes().size());
+    for (int memberIndex : channelGroup.GetMemberChannelIndexes())
+      body.WriteInt(memberIndex);
+  }
+
+  SnapshotWriter stringTable;
+  stringTable.WriteUInt(body.GetStrings().size());
+  for (const std::string* value : body.GetStrings())
+    stringTable.WriteString(*value);
+
+  std::string snapshot = CreateHeader(m3uLocation, contentHash);
+  snapshot.reserve(snapshot.length() + stringTable.GetData().length() + body.GetData().length());
+  snapshot.append(stringTable.GetData());
+  snapshot.append(body.GetData());
+
+  return snapshot;
+}
+
+bool PlaylistSnapshot::Write(const std::string& snapshot)
+{
+  const std::string snapshotPath = FileUtils::GetUserFilePath(M3U_SNAPSHOT_FILE_NAME);
+  const std::string tempSnapshotPath = snapshotPath + TEMP_FILE_EXTENSION;
+
+  // Written to a temporary file first so a failed write never replaces a good snapshot
+  void* fileHandle = XBMC->OpenFileForWrite(tempSnapshotPath.c_str(), true);
+  if (!fileHandle)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Unable to write playlist snapshot '%s'", __FUNCTION__, tempSnapshotPath.c_str());
+    return false;
+  }
+
+  const bool written = XBMC->WriteFile(fileHandle, snapshot.data(), snapshot.length()) == static_cast<ssize_t>(snapshot.length());
+  XBMC->CloseFile(fileHandle);
+
+  if (!written)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Unable to write playlist snapshot '%s'", __FUNCTION__, tempSnapshotPath.c_str());
+    XBMC->DeleteFile(tempSnapshotPath.c_str());
+    return false;
+  }
+
+  if (!FileUtils::CommitTempFile(tempSnapshotPath, snapshotPath))
+    return false;
+
+  Logger::Log(LEVEL_DEBUG, "%s - Saved playlist snapshot of %zu bytes", __FUNCTION__, snapshot.length());
+  return true;
+}
+
+bool PlaylistSnapshot::Save(const std::string& m3uLocation, const Channels& channels, const ChannelGroups& channelGroups, uint64_t contentHash)
+{
+  // Nothing to do if the snapshot on disk is for the same playlist content and settings
+  if (IsSaved(m3uLocation, contentHash))
+    return true;
+
+  return Write(Serialise(m3uLocation, channels, channelGroups, contentHash));
+}
@@ -0,0 +1,60 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Channels.h"
+#include "ChannelGroups.h"
+
+#include <cstdint>
+#include <string>
+
+namespace iptvsimple
+{
+  /**
+   * A binary image of the parsed channels and channel groups so they can be
+   * published at startup without waiting for the playlist to be downloaded
+   * and parsed. A snapshot is only valid for the playlist location and the
+   * settings that were used to parse it.
+   */
+  class PlaylistSnapshot
+  {
+  public:
+    static bool Load(const std::string& m3uLocation, iptvsimple::Channels& channels,
+                     iptvsimple::ChannelGroups& channelGroups, uint64_t& contentHash);
+    static bool Save(const std::string& m3uLocation, const iptvsimple::Channels& channels,
+                     const iptvsimple::ChannelGroups& channelGroups, uint64_t contentHash);
+
+    /**
+     * Save() split into its steps so only Serialise() needs to run while the
+     * channels are locked, the disk I/O can then be done without the lock.
+     */
+    static bool IsSaved(const std::string& m3uLocation, uint64_t contentHash);
+    static std::string Serialise(const std::string& m3uLocation, const iptvsimple::Channels& channels,
+                                 const iptvsimple::ChannelGroups& channelGroups, uint64_t contentHash);
+    static bool Write(const std::string& snapshot);
+
+  private:
+    static const uint32_t SNAPSHOT_VERSION = 1;
+
+    static std::string CreateHeader(const std::string& m3uLocation, uint64_t contentHash);
+  };
+} //namespace iptvsimple
@@ -56,6 +56,8 @@ void Settings::ReadFromAddon(const std::string& userPath, const std::string clie
       m_cacheM3U = true;
   if (!XBMC->GetSetting("startNum", &m_startChannelNumber))
     m_startChannelNumber = 1;
+  if (!XBMC->GetSetting("m3uRefreshMins", &m_m3uRefreshIntervalMins))
+    m_m3uRefreshIntervalMins = 0;
 
   // EPG
   if (!XBMC->GetSetting("epgPathType", &m_epgPathType))
@@ -70,6 +72,8 @@ void Settings::ReadFromAddon(const std::string& userPath, const std::string clie
     m_epgTimeShiftMins = 0;
   if (!XBMC->GetSetting("epgTSOverride", &m_tsOverride))
     m_tsOverride = true;
+  if (!XBMC->GetSetting("epgRefreshMins", &m_epgRefreshIntervalMins))
+    m_epgRefreshIntervalMins = 0;
 
   // Channel Logos
   if (!XBMC->GetSetting("logoPathType", &m_logoPathType))
@@ -80,55 +84,78 @@ void Settings::ReadFromAddon(const std::string& userPath, const std::string clie
     m_logoBaseUrl = buffer;
   if (!XBMC->GetSetting("logoFromEpg", &m_epgLogosMode))
     m_epgLogosMode = EpgLogosMode::IGNORE_XMLTV;
+
+  // Advanced
+  if (!XBMC->GetSetting("collectMetrics", &m_collectMetrics))
+    m_collectMetrics = false;
+  if (!XBMC->GetSetting("traceEnabled", &m_traceEnabled))
+    m_traceEnabled = false;
 }
 
-ADDON_STATUS Settings::SetValue(const std::string& settingName, const void* settingValue)
+SettingScope Settings::SetValue(const std::string& settingName, const void* settingValue)
 {
-  // reset cache and restart addon
+  const SettingScope scope = SetValueInScope(settingName, settingValue);
 
-  std::string strFile = FileUtils::GetUserFilePath(M3U_FILE_NAME);
-  if (XBMC->FileExists(strFile.c_str(), false))
-    XBMC->DeleteFile(strFile.c_str());
+  // reset the cache of anything that is going to be reloaded
+  std::string strFile;
+  if (scope == SettingScope::PLAYLIST)
+    strFile = FileUtils::GetUserFilePath(M3U_FILE_NAME);
+  else if (scope == SettingScope::EPG)
+    strFile = FileUtils::GetUserFilePath(TVG_FILE_NAME);
 
-  strFile = FileUtils::GetUserFilePath(TVG_FILE_NAME);
-  if (XBMC->FileExists(strFile.c_str(), false))
+  if (!strFile.empty() && XBMC->FileExists(strFile.c_str(), false))
     XBMC->DeleteFile(strFile.c_str());
 
+  return scope;
+}
+
+SettingScope Settings::SetValueInScope(const std::string& settingName, const void* settingValue)
+{
   // M3U
   if (settingName == "m3uPathType")
-    return SetSetting<PathType, ADDON_STATUS>(settingName, settingValue, m_m3uPathType, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<PathType, SettingScope>(settingName, settingValue, m_m3uPathType, SettingScope::PLAYLIST, SettingScope::NONE);
   if (settingName == "m3uPath")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_m3uPath, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_m3uPath, SettingScope::PLAYLIST, SettingScope::NONE);
   if (settingName == "m3uUrl")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_m3uUrl, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_m3uUrl, SettingScope::PLAYLIST, SettingScope::NONE);
   if (settingName == "m3uCache")
-    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_cacheM3U, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<bool, SettingScope>(settingName, settingValue, m_cacheM3U, SettingScope::PLAYLIST, SettingScope::NONE);
   if (settingName == "startNum")
-    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_startChannelNumber, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<int, SettingScope>(settingName, settingValue, m_startChannelNumber, SettingScope::PLAYLIST, SettingScope::NONE);
+  if (settingName == "m3uRefreshMins")
+    return SetSetting<int, SettingScope>(settingName, settingValue, m_m3uRefreshIntervalMins, SettingScope::REFRESH_INTERVALS, SettingScope::NONE);
 
   // EPG
   if (settingName == "epgPathType")
-    return SetSetting<PathType, ADDON_STATUS>(settingName, settingValue, m_epgPathType, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<PathType, SettingScope>(settingName, settingValue, m_epgPathType, SettingScope::EPG, SettingScope::NONE);
   if (settingName == "epgPath")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_epgPath, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_epgPath, SettingScope::EPG, SettingScope::NONE);
   if (settingName == "epgUrl")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_epgUrl, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_epgUrl, SettingScope::EPG, SettingScope::NONE);
   if (settingName == "epgCache")
-    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_cacheEPG, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<bool, SettingScope>(settingName, settingValue, m_cacheEPG, SettingScope::EPG, SettingScope::NONE);
   if (settingName == "epgTimeShift")
-    return SetSetting<int, ADDON_STATUS>(settingName, settingValue, m_epgTimeShiftMins, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<int, SettingScope>(settingName, settingValue, m_epgTimeShiftMins, SettingScope::EPG_TIMESHIFT, SettingScope::NONE);
   if (settingName == "epgTSOverride")
-    return SetSetting<bool, ADDON_STATUS>(settingName, settingValue, m_tsOverride, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<bool, SettingScope>(settingName, settingValue, m_tsOverride, SettingScope::EPG_TIMESHIFT, SettingScope::NONE);
+  if (settingName == "epgRefreshMins")
+    return SetSetting<int, SettingScope>(settingName, settingValue, m_epgRefreshIntervalMins, SettingScope::REFRESH_INTERVALS, SettingScope::NONE);
 
   // Channel Logos
   if (settingName == "logoPathType")
-    return SetSetting<PathType, ADDON_STATUS>(settingName, settingValue, m_logoPathType, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<PathType, SettingScope>(settingName, settingValue, m_logoPathType, SettingScope::LOGOS, SettingScope::NONE);
   if (settingName == "logoPath")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_logoPath, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_logoPath, SettingScope::LOGOS, SettingScope::NONE);
   if (settingName == "logoBaseUrl")
-    return SetStringSetting<ADDON_STATUS>(settingName, settingValue, m_logoBaseUrl, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetStringSetting<SettingScope>(settingName, settingValue, m_logoBaseUrl, SettingScope::LOGOS, SettingScope::NONE);
   if (settingName == "logoFromEpg")
-    return SetSetting<EpgLogosMode, ADDON_STATUS>(settingName, settingValue, m_epgLogosMode, ADDON_STATUS_OK, ADDON_STATUS_OK);
+    return SetSetting<EpgLogosMode, SettingScope>(settingName, settingValue, m_epgLogosMode, SettingScope::LOGOS, SettingScope::NONE);
+
+  // Advanced
+  if (settingName == "collectMetrics")
+    return SetSetting<bool, SettingScope>(settingName, settingValue, m_collectMetrics, SettingScope::METRICS, SettingScope::NONE);
+  if (settingName == "traceEnabled")
+    return SetSetting<bool, SettingScope>(settingName, settingValue, m_traceEnabled, SettingScope::TRACING, SettingScope::NONE);
 
-  return ADDON_STATUS_OK;
+  return SettingScope::NONE;
 }
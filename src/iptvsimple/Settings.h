@@ -30,6 +30,7 @@
 namespace iptvsimple
 {
   static const std::string M3U_FILE_NAME = "iptv.m3u.cache";
+  static const std::string M3U_SNAPSHOT_FILE_NAME = "iptv.m3u.snapshot";
   static const std::string TVG_FILE_NAME = "xmltv.xml.cache";
 
   enum class PathType
@@ -47,6 +48,19 @@ namespace iptvsimple
     PREFER_XMLTV
   };
 
+  enum class SettingScope
+    : int
+  {
+    NONE = 0,
+    PLAYLIST,
+    EPG,
+    EPG_TIMESHIFT,
+    LOGOS,
+    REFRESH_INTERVALS,
+    METRICS,
+    TRACING
+  };
+
   class Settings
   {
   public:
@@ -60,7 +74,10 @@ namespace iptvsimple
     }
 
     void ReadFromAddon(const std::string& userPath, const std::string clientPath);
-    ADDON_STATUS SetValue(const std::string& settingName, const void* settingValue);
+    /**
+     * Returns what has to be reloaded or reapplied because of the change, NONE if the value is unchanged
+     */
+    SettingScope SetValue(const std::string& settingName, const void* settingValue);
 
     const std::string& GetUserPath() const { return m_userPath; }
     const std::string& GetClientPath() const { return m_clientPath; }
@@ -71,6 +88,7 @@ namespace iptvsimple
     const std::string& GetM3UUrl() const { return m_m3uUrl; }
     bool UseM3UCache() const { return m_m3uPathType == PathType::REMOTE_PATH ? m_cacheM3U : false; }
     int GetStartChannelNumber() const { return m_startChannelNumber; }
+    int GetM3URefreshIntervalMins() const { return m_m3uRefreshIntervalMins; }
 
     const std::string& GetEpgLocation() const { return m_epgPathType == PathType::REMOTE_PATH ? m_epgUrl : m_epgPath; }
     const PathType& GetEpgPathType() const { return m_epgPathType; }
@@ -80,6 +98,7 @@ namespace iptvsimple
     int GetEpgTimeshiftMins() const { return m_epgTimeShiftMins; }
     int GetEpgTimeshiftSecs() const { return m_epgTimeShiftMins * 60; }
     bool GetTsOverride() const { return m_tsOverride; }
+    int GetEpgRefreshIntervalMins() const { return m_epgRefreshIntervalMins; }
 
     const std::string& GetLogoLocation() const { return m_logoPathType == PathType::REMOTE_PATH ? m_logoBaseUrl : m_logoPath; }
     const PathType& GetLogoPathType() const { return m_logoPathType; }
@@ -87,12 +106,17 @@ namespace iptvsimple
     const std::string& GetLogoBaseUrl() const { return m_logoBaseUrl; }
     const EpgLogosMode& GetEpgLogosMode() const { return m_epgLogosMode; }
 
+    bool CollectMetrics() const { return m_collectMetrics; }
+    bool TraceEnabled() const { return m_traceEnabled; }
+
   private:
     Settings() = default;
 
     Settings(Settings const&) = delete;
     void operator=(Settings const&) = delete;
 
+    SettingScope SetValueInScope(const std::string& settingName, const void* settingValue);
+
     template <typename T, typename V>
     V SetSetting(const std::string& settingName, const void* settingValue, T& currentValue, V returnValueIfChanged, V defaultReturnValue)
     {
@@ -130,6 +154,7 @@ namespace iptvsimple
     std::string m_m3uUrl = "";
     bool m_cacheM3U = false;
     int m_startChannelNumber = 1;
+    int m_m3uRefreshIntervalMins = 0;
 
     PathType m_epgPathType = PathType::REMOTE_PATH;
     std::string m_epgPath = "";
@@ -137,10 +162,14 @@ namespace iptvsimple
     bool m_cacheEPG = false;
     int m_epgTimeShiftMins = 0;
     bool m_tsOverride = true;
+    int m_epgRefreshIntervalMins = 0;
 
     PathType m_logoPathType = PathType::REMOTE_PATH;
     std::string m_logoPath = "";
     std::string m_logoBaseUrl = "";
     EpgLogosMode m_epgLogosMode = EpgLogosMode::IGNORE_XMLTV;
+
+    bool m_collectMetrics = false;
+    bool m_traceEnabled = false;
   };
 } //namespace iptvsimple
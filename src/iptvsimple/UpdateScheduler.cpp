@@ -0,0 +1,109 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "UpdateScheduler.h"
+
+#include "utilities/Logger.h"
+
+#include <algorithm>
+
+using namespace iptvsimple;
+using namespace iptvsimple::utilities;
+
+void UpdateScheduler::Schedule(UpdateJob job, const std::chrono::milliseconds& delay)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dueTimes[job] = std::chrono::steady_clock::now() + delay;
+  }
+
+  Logger::Log(LEVEL_DEBUG, "%s - Scheduled job %d in %d ms", __FUNCTION__, static_cast<int>(job), static_cast<int>(delay.count()));
+
+  m_condition.notify_all();
+}
+
+void UpdateScheduler::ScheduleNoLaterThan(UpdateJob job, const std::chrono::milliseconds& delay)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto dueTime = std::chrono::steady_clock::now() + delay;
+
+    auto dueTimePair = m_dueTimes.find(job);
+    if (dueTimePair != m_dueTimes.end() && dueTimePair->second <= dueTime)
+      return;
+
+    m_dueTimes[job] = dueTime;
+  }
+
+  Logger::Log(LEVEL_DEBUG, "%s - Scheduled job %d in %d ms", __FUNCTION__, static_cast<int>(job), static_cast<int>(delay.count()));
+
+  m_condition.notify_all();
+}
+
+void UpdateScheduler::Cancel(UpdateJob job)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_dueTimes.erase(job);
+}
+
+bool UpdateScheduler::WaitForDueJob(UpdateJob& job)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  while (!m_stopped)
+  {
+    if (m_dueTimes.empty())
+    {
+      m_condition.wait(lock);
+      continue;
+    }
+
+    auto nextJob = std::min_element(m_dueTimes.begin(), m_dueTimes.end(),
+      [](const std::pair<const UpdateJob, std::chrono::steady_clock::time_point>& left,
+         const std::pair<const UpdateJob, std::chrono::steady_clock::time_point>& right)
+      {
+        return left.second < right.second;
+      });
+
+    if (nextJob->second <= std::chrono::steady_clock::now())
+    {
+      job = nextJob->first;
+      m_dueTimes.erase(nextJob);
+      return true;
+    }
+
+    // Woken early if a job is scheduled or moved, the earliest job is then found again
+    m_condition.wait_until(lock, nextJob->second);
+  }
+
+  return false;
+}
+
+void UpdateScheduler::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopped = true;
+  }
+
+  m_condition.notify_all();
+}
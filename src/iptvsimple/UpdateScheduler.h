@@ -0,0 +1,66 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+namespace iptvsimple
+{
+  enum class UpdateJob
+    : int
+  {
+    RELOAD_PLAYLIST = 0,
+    RELOAD_EPG,
+    REFRESH_EPG,
+    APPLY_EPG_TIMESHIFT,
+    APPLY_CHANNEL_LOGOS
+  };
+
+  /**
+   * Jobs for the update thread. Each job is either pending with a due time or not
+   * scheduled at all, so scheduling a pending job again just moves its due time.
+   * This is what coalesces a burst of setting changes into a single reload.
+   */
+  class UpdateScheduler
+  {
+  public:
+    void Schedule(UpdateJob job, const std::chrono::milliseconds& delay);
+    void ScheduleNoLaterThan(UpdateJob job, const std::chrono::milliseconds& delay);
+    void Cancel(UpdateJob job);
+
+    /**
+     * Blocks until a job is due and removes it from the schedule.
+     * Returns false once the scheduler is stopped.
+     */
+    bool WaitForDueJob(UpdateJob& job);
+    void Stop();
+
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::map<UpdateJob, std::chrono::steady_clock::time_point> m_dueTimes;
+    bool m_stopped = false;
+  };
+} //namespace iptvsimple
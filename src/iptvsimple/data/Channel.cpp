@@ -22,8 +22,11 @@
 
 #include "Channel.h"
 
+#include "../utilities/MemoryUtils.h"
+
 using namespace iptvsimple;
 using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
 
 void Channel::UpdateTo(Channel& left) const
 {
@@ -66,4 +69,12 @@ void Channel::Reset()
   m_tvgName.clear();
   m_tvgLogo.clear();
   m_properties.clear();
-}
\ No newline at end of file
+}
+
+size_t Channel::GetMemoryUsage() const
+{
+  return MemoryUtils::GetHeapSize(m_channelName) + MemoryUtils::GetHeapSize(m_logoPath) +
+         MemoryUtils::GetHeapSize(m_streamURL) + MemoryUtils::GetHeapSize(m_tvgId) +
+         MemoryUtils::GetHeapSize(m_tvgName) + MemoryUtils::GetHeapSize(m_tvgLogo) +
+         MemoryUtils::GetHeapSize(m_properties);
+}
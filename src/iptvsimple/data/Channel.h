@@ -25,6 +25,7 @@
 
 #include <map>
 #include <string>
+#include <utility>
 
 namespace iptvsimple
 {
@@ -34,13 +35,6 @@ namespace iptvsimple
     {
     public:
       Channel() = default;
-      Channel(const Channel &c) : m_radio(c.IsRadio()), m_uniqueId(c.GetUniqueId()),
-        m_channelNumber(c.GetChannelNumber()), m_encryptionSystem(c.GetEncryptionSystem()),
-        m_tvgShift(c.GetTvgShift()), m_channelName(c.GetChannelName()), m_logoPath(c.GetLogoPath()),
-        m_streamURL(c.GetStreamURL()), m_tvgId(c.GetTvgId()),
-        m_tvgName(c.GetTvgName()), m_tvgLogo(c.GetTvgLogo()),
-        m_properties(c.GetProperties()) {};
-      ~Channel() = default;
 
       bool IsRadio() const { return m_radio; }
       void SetRadio(bool value) { m_radio = value; }
@@ -59,29 +53,37 @@ namespace iptvsimple
 
       const std::string& GetChannelName() const { return m_channelName; }
       void SetChannelName(const std::string& value) { m_channelName = value; }
+      void SetChannelName(std::string&& value) { m_channelName = std::move(value); }
 
       const std::string& GetLogoPath() const { return m_logoPath; }
       void SetLogoPath(const std::string& value) { m_logoPath = value; }
+      void SetLogoPath(std::string&& value) { m_logoPath = std::move(value); }
 
       const std::string& GetStreamURL() const { return m_streamURL; }
       void SetStreamURL(const std::string& value) { m_streamURL = value; }
+      void SetStreamURL(std::string&& value) { m_streamURL = std::move(value); }
 
       const std::string& GetTvgId() const { return m_tvgId; }
       void SetTvgId(const std::string& value) { m_tvgId = value; }
+      void SetTvgId(std::string&& value) { m_tvgId = std::move(value); }
 
       const std::string& GetTvgName() const { return m_tvgName; }
       void SetTvgName(const std::string& value) { m_tvgName = value; }
+      void SetTvgName(std::string&& value) { m_tvgName = std::move(value); }
 
       const std::string& GetTvgLogo() const { return m_tvgLogo; }
       void SetTvgLogo(const std::string& value) { m_tvgLogo = value; }
+      void SetTvgLogo(std::string&& value) { m_tvgLogo = std::move(value); }
 
       const std::map<std::string, std::string>& GetProperties() const { return m_properties; }
       void SetProperties(std::map<std::string, std::string>& value) { m_properties = value; }
       void AddProperty(const std::string& prop, const std::string& value) { m_properties.insert({prop, value}); }
+      void AddProperty(std::string&& prop, std::string&& value) { m_properties.emplace(std::move(prop), std::move(value)); }
 
       void UpdateTo(Channel& left) const;
       void UpdateTo(PVR_CHANNEL& left) const;
       void Reset();
+      size_t GetMemoryUsage() const;
 
     private:
       bool m_radio = false;
@@ -22,10 +22,12 @@
 
 #include "ChannelEpg.h"
 
+#include "../utilities/MemoryUtils.h"
 #include "../utilities/XMLUtils.h"
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
 using namespace rapidxml;
 
 bool ChannelEpg::UpdateFrom(xml_node<>* channelNode, Channels& channels)
@@ -50,4 +52,15 @@ bool ChannelEpg::UpdateFrom(xml_node<>* channelNode, Channels& channels)
     m_icon = icon;
 
   return true;
-}
\ No newline at end of file
+}
+
+size_t ChannelEpg::GetMemoryUsage() const
+{
+  size_t size = MemoryUtils::GetHeapSize(m_id) + MemoryUtils::GetHeapSize(m_name) +
+                MemoryUtils::GetHeapSize(m_icon) + MemoryUtils::GetHeapSize(m_epgEntries);
+
+  for (const auto& epgEntry : m_epgEntries)
+    size += epgEntry.GetMemoryUsage();
+
+  return size;
+}
@@ -28,6 +28,7 @@
 #include "rapidxml/rapidxml.hpp"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace iptvsimple
@@ -47,9 +48,11 @@ namespace iptvsimple
       void SetIcon(const std::string& value) { m_icon = value; }
 
       std::vector<EpgEntry>& GetEpgEntries() { return m_epgEntries; }
-      void AddEpgEntry(const EpgEntry& epgEntry) { m_epgEntries.emplace_back(epgEntry); }
+      void AddEpgEntry(EpgEntry&& epgEntry) { m_epgEntries.emplace_back(std::move(epgEntry)); }
+      void ReserveEpgEntries(size_t count) { m_epgEntries.reserve(count); }
 
       bool UpdateFrom(rapidxml::xml_node<>* channelNode, iptvsimple::Channels& channels);
+      size_t GetMemoryUsage() const;
 
     private:
       std::string m_id;
@@ -22,12 +22,20 @@
 
 #include "ChannelGroup.h"
 
+#include "../utilities/MemoryUtils.h"
+
 using namespace iptvsimple;
 using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
 
 void ChannelGroup::UpdateTo(PVR_CHANNEL_GROUP& left) const
 {
   left.bIsRadio = m_radio;
   left.iPosition = 0; // groups default order, unused
   strncpy(left.strGroupName, m_groupName.c_str(), sizeof(left.strGroupName) - 1);
-}
\ No newline at end of file
+}
+
+size_t ChannelGroup::GetMemoryUsage() const
+{
+  return MemoryUtils::GetHeapSize(m_groupName) + MemoryUtils::GetHeapSize(m_memberChannelIndexes);
+}
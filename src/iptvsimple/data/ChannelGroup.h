@@ -46,6 +46,7 @@ namespace iptvsimple
       void AddMemberChannelIndex(int channelIndex) { m_memberChannelIndexes.emplace_back(channelIndex); }
 
       void UpdateTo(PVR_CHANNEL_GROUP& left) const;
+      size_t GetMemoryUsage() const;
 
     private:
       bool m_radio;
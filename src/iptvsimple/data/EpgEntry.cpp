@@ -22,6 +22,7 @@
 
 #include "EpgEntry.h"
 
+#include "../utilities/MemoryUtils.h"
 #include "../utilities/XMLUtils.h"
 
 #include "p8-platform/util/StringUtils.h"
@@ -31,6 +32,7 @@
 
 using namespace iptvsimple;
 using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
 using namespace rapidxml;
 
 void EpgEntry::UpdateTo(EPG_TAG& left, int iChannelUid, int timeShift, std::vector<EpgGenre>& genres)
@@ -115,7 +117,7 @@ long long GetUTCTime(int year, int mon, int mday, int hour, int min, int sec)
   return (((MakeTime(y, m, mday) - MakeTime(1970 + 99, 12, 1)) * 24 + hour) * 60 + min) * 60 + sec;
 }
 
-long long ParseDateTime(const std::string& strDate)
+long long ParseDateTime(const char* strDate)
 {
   int year = 2000;
   int mon = 1;
@@ -127,7 +129,7 @@ long long ParseDateTime(const std::string& strDate)
   int offset_hours = 0;
   int offset_minutes = 0;
 
-  sscanf(strDate.c_str(), "%04d%02d%02d%02d%02d%02d %c%02d%02d", &year, &mon, &mday, &hour, &min, &sec, &offset_sign, &offset_hours, &offset_minutes);
+  sscanf(strDate, "%04d%02d%02d%02d%02d%02d %c%02d%02d", &year, &mon, &mday, &hour, &min, &sec, &offset_sign, &offset_hours, &offset_minutes);
 
   long offset_of_date = (offset_hours * 60 + offset_minutes) * 60;
   if (offset_sign == '-')
@@ -138,16 +140,38 @@ long long ParseDateTime(const std::string& strDate)
 
 } // unnamed namespace
 
+bool EpgEntry::GetStartAndEndTimes(const rapidxml::xml_node<>* channelNode, long long& start, long long& end)
+{
+  // Read the attribute values in place, there is no need to copy them for parsing
+  const xml_attribute<>* startAttribute = channelNode->first_attribute("start");
+  const xml_attribute<>* stopAttribute = channelNode->first_attribute("stop");
+  if (!startAttribute || !stopAttribute)
+    return false;
+
+  start = ParseDateTime(startAttribute->value());
+  end = ParseDateTime(stopAttribute->value());
+
+  return true;
+}
+
+bool EpgEntry::IsInWindow(const rapidxml::xml_node<>* channelNode, int start, int end, int minShiftTime, int maxShiftTime)
+{
+  long long tmpStart;
+  long long tmpEnd;
+  if (!GetStartAndEndTimes(channelNode, tmpStart, tmpEnd))
+    return false;
+
+  return !((tmpEnd + maxShiftTime < start) || (tmpStart + minShiftTime > end));
+}
+
 bool EpgEntry::UpdateFrom(rapidxml::xml_node<>* channelNode, const std::string& id, int broadcastId,
                           int start, int end, int minShiftTime, int maxShiftTime)
 {
-  std::string strStart, strStop;
-  if (!GetAttributeValue(channelNode, "start", strStart) || !GetAttributeValue(channelNode, "stop", strStop))
+  long long tmpStart;
+  long long tmpEnd;
+  if (!GetStartAndEndTimes(channelNode, tmpStart, tmpEnd))
     return false;
 
-  long long tmpStart = ParseDateTime(strStart);
-  long long tmpEnd = ParseDateTime(strStop);
-
   if ((tmpEnd + maxShiftTime < start) || (tmpStart + minShiftTime > end))
     return false;
 
@@ -155,7 +179,7 @@ bool EpgEntry::UpdateFrom(rapidxml::xml_node<>* channelNode, const std::string&
   m_channelId = std::atoi(id.c_str());
   m_genreType = 0;
   m_genreSubType = 0;
-  m_plotOutline= "";
+  m_plotOutline.clear();
   m_startTime = static_cast<time_t>(tmpStart);
   m_endTime = static_cast<time_t>(tmpEnd);
 
@@ -173,11 +197,17 @@ bool EpgEntry::UpdateFrom(rapidxml::xml_node<>* channelNode, const std::string&
   }
 
   xml_node<>* iconNode = channelNode->first_node("icon");
-  std::string iconPath;
-  if (!iconNode || !GetAttributeValue(iconNode, "src", iconPath))
-    m_iconPath = "";
-  else
-    m_iconPath = iconPath;
+  if (!iconNode || !GetAttributeValue(iconNode, "src", m_iconPath))
+    m_iconPath.clear();
 
   return true;
-}
\ No newline at end of file
+}
+
+size_t EpgEntry::GetMemoryUsage() const
+{
+  return MemoryUtils::GetHeapSize(m_title) + MemoryUtils::GetHeapSize(m_episodeName) +
+         MemoryUtils::GetHeapSize(m_plotOutline) + MemoryUtils::GetHeapSize(m_plot) +
+         MemoryUtils::GetHeapSize(m_iconPath) + MemoryUtils::GetHeapSize(m_genreString) +
+         MemoryUtils::GetHeapSize(m_cast) + MemoryUtils::GetHeapSize(m_director) +
+         MemoryUtils::GetHeapSize(m_writer);
+}
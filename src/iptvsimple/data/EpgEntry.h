@@ -86,7 +86,12 @@ namespace iptvsimple
       bool UpdateFrom(rapidxml::xml_node<>* channelNode, const std::string& id, int broadcastId,
                       int start, int end, int minShiftTime, int maxShiftTime);
 
+      static bool IsInWindow(const rapidxml::xml_node<>* channelNode, int start, int end, int minShiftTime, int maxShiftTime);
+
+      size_t GetMemoryUsage() const;
+
     private:
+      static bool GetStartAndEndTimes(const rapidxml::xml_node<>* channelNode, long long& start, long long& end);
       bool SetEpgGenre(std::vector<EpgGenre> genres, const std::string& genreToFind);
 
       int m_broadcastId;
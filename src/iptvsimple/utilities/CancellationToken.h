@@ -0,0 +1,44 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <atomic>
+
+namespace iptvsimple
+{
+  namespace utilities
+  {
+    /**
+     * Shared between whoever starts long running work and the work itself,
+     * which checks it at convenient points and gives up once cancelled.
+     */
+    class CancellationToken
+    {
+    public:
+      void Cancel() { m_cancelled = true; }
+      bool IsCancelled() const { return m_cancelled; }
+
+    private:
+      std::atomic_bool m_cancelled{false};
+    };
+  } // namespace utilities
+} // namespace iptvsimple
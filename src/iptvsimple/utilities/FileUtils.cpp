@@ -21,13 +21,24 @@
 
 #include "FileUtils.h"
 
+#include "Logger.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include "../Settings.h"
 #include "../../client.h"
 #include "zlib.h"
 
+#include <cstdio>
+
 using namespace iptvsimple;
 using namespace iptvsimple::utilities;
 
+#ifdef TARGET_WINDOWS
+#ifdef DeleteFile
+#undef DeleteFile
+#endif
+#endif
+
 std::string FileUtils::PathCombine(const std::string& path, const std::string& fileName)
 {
   std::string result = path;
@@ -66,16 +77,103 @@ std::string FileUtils::GetUserFilePath(const std::string& fileName)
 int FileUtils::GetFileContents(const std::string& url, std::string& content)
 {
   content.clear();
+
+  return StreamFileContents(url, [&content](const char* data, size_t length)
+  {
+    content.append(data, length);
+  });
+}
+
+FetchOptions FileUtils::CreateFetchOptions(const CancellationToken& cancellationToken, const std::string& description,
+                                           int stallTimeoutSecs /* DEFAULT_FETCH_STALL_TIMEOUT_SECS */)
+{
+  FetchOptions options;
+  options.cancellationToken = &cancellationToken;
+  options.stallTimeout = std::chrono::seconds(stallTimeoutSecs);
+
+  size_t nextLogBytes = FETCH_PROGRESS_LOG_INTERVAL_BYTES;
+  options.progressHandler = [description, nextLogBytes](size_t totalBytesRead) mutable
+  {
+    if (totalBytesRead >= nextLogBytes)
+    {
+      Logger::Log(LEVEL_DEBUG, "%s - Fetched %zu KB of %s", __FUNCTION__, totalBytesRead / 1024, description.c_str());
+      nextLogBytes = totalBytesRead + FETCH_PROGRESS_LOG_INTERVAL_BYTES;
+    }
+  };
+
+  return options;
+}
+
+int FileUtils::StreamFileContents(const std::string& url, const FileDataHandler& dataHandler, const FetchOptions& options /* FetchOptions() */)
+{
+  int totalBytesRead = 0;
+
+  // Only the time spent fetching is recorded, not the time the handler spends on the data
+  const bool metricsEnabled = Metrics::IsEnabled();
+  std::chrono::steady_clock::time_point fetchStart;
+  std::chrono::steady_clock::duration handlerDuration(0);
+  if (metricsEnabled)
+    fetchStart = std::chrono::steady_clock::now();
+
   void* fileHandle = XBMC->OpenFile(url.c_str(), 0);
   if (fileHandle)
   {
-    char buffer[1024];
-    while (int bytesRead = XBMC->ReadFile(fileHandle, buffer, 1024))
-      content.append(buffer, bytesRead);
+    char buffer[READ_CHUNK_SIZE];
+    ssize_t bytesRead;
+    std::chrono::steady_clock::time_point lastReadEnd = std::chrono::steady_clock::now();
+    while ((bytesRead = XBMC->ReadFile(fileHandle, buffer, READ_CHUNK_SIZE)) > 0)
+    {
+      // Only the wait for this read counts, so the time the handler takes never adds up to a stall
+      const std::chrono::steady_clock::time_point readEnd = std::chrono::steady_clock::now();
+      if (readEnd - lastReadEnd > options.stallTimeout)
+      {
+        Logger::Log(LEVEL_ERROR, "%s - Fetch of '%s' stalled after %d bytes", __FUNCTION__, url.c_str(), totalBytesRead);
+        totalBytesRead = 0;
+        break;
+      }
+
+      if (metricsEnabled)
+      {
+        const std::chrono::steady_clock::time_point handlerStart = std::chrono::steady_clock::now();
+        dataHandler(buffer, bytesRead);
+        handlerDuration += std::chrono::steady_clock::now() - handlerStart;
+      }
+      else
+      {
+        dataHandler(buffer, bytesRead);
+      }
+      totalBytesRead += bytesRead;
+
+      if (options.progressHandler)
+        options.progressHandler(totalBytesRead);
+
+      // A partial file is of no use to anyone so an aborted fetch reads as nothing
+      if (options.cancellationToken && options.cancellationToken->IsCancelled())
+      {
+        Logger::Log(LEVEL_NOTICE, "%s - Fetch of '%s' cancelled after %d bytes", __FUNCTION__, url.c_str(), totalBytesRead);
+        totalBytesRead = 0;
+        break;
+      }
+
+      lastReadEnd = std::chrono::steady_clock::now();
+    }
+
+    if (bytesRead < 0)
+    {
+      Logger::Log(LEVEL_ERROR, "%s - Fetch of '%s' failed after %d bytes", __FUNCTION__, url.c_str(), totalBytesRead);
+      totalBytesRead = 0;
+    }
+
     XBMC->CloseFile(fileHandle);
   }
 
-  return content.length();
+  if (metricsEnabled)
+  {
+    Metrics::Add(MetricCounter::DOWNLOAD_BYTES, totalBytesRead);
+    Metrics::Record(MetricTimer::DOWNLOAD, std::chrono::steady_clock::now() - fetchStart - handlerDuration);
+  }
+
+  return totalBytesRead;
 }
 
 /*
@@ -86,6 +184,8 @@ int FileUtils::GetFileContents(const std::string& url, std::string& content)
 
 bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes)
 {
+  ScopedTraceSpan span("FileUtils::GzipInflate");
+
   if (compressedBytes.size() == 0)
   {
     uncompressedBytes = compressedBytes;
@@ -152,8 +252,23 @@ bool FileUtils::GzipInflate(const std::string& compressedBytes, std::string& unc
 }
 
 int FileUtils::GetCachedFileContents(const std::string& cachedName, const std::string& filePath,
-                                       std::string& contents, const bool useCache /* false */)
+                                       std::string& contents, const bool useCache /* false */,
+                                       const FetchOptions& options /* FetchOptions() */)
 {
+  ScopedTraceSpan span("FileUtils::GetCachedFileContents");
+  contents.clear();
+
+  return StreamCachedFileContents(cachedName, filePath, [&contents](const char* data, size_t length)
+  {
+    contents.append(data, length);
+  }, useCache, options);
+}
+
+int FileUtils::StreamCachedFileContents(const std::string& cachedName, const std::string& filePath,
+                                        const FileDataHandler& dataHandler, const bool useCache /* false */,
+                                        const FetchOptions& options /* FetchOptions() */)
+{
+  ScopedTraceSpan span("FileUtils::StreamCachedFileContents");
   bool needReload = false;
   const std::string cachedPath = FileUtils::GetUserFilePath(cachedName);
 
@@ -175,20 +290,66 @@ int FileUtils::GetCachedFileContents(const std::string& cachedName, const std::s
 
   if (needReload)
   {
-    FileUtils::GetFileContents(filePath, contents);
+    // Write to the cache as the data arrives, into a temporary file so the last good cache
+    // is only replaced once the whole file has been fetched and written
+    const std::string tempCachedPath = cachedPath + TEMP_FILE_EXTENSION;
+    void* cacheFileHandle = nullptr;
+    if (useCache)
+      cacheFileHandle = XBMC->OpenFileForWrite(tempCachedPath.c_str(), true);
+    bool cacheWritten = true;
 
-    // write to cache
-    if (useCache && contents.length() > 0)
+    const int bytesRead = FileUtils::StreamFileContents(filePath, [&](const char* data, size_t length)
     {
-      void* fileHandle = XBMC->OpenFileForWrite(cachedPath.c_str(), true);
-      if (fileHandle)
-      {
-        XBMC->WriteFile(fileHandle, contents.c_str(), contents.length());
-        XBMC->CloseFile(fileHandle);
-      }
+      if (cacheFileHandle)
+        cacheWritten &= XBMC->WriteFile(cacheFileHandle, data, length) == static_cast<ssize_t>(length);
+
+      dataHandler(data, length);
+    }, options);
+
+    if (cacheFileHandle)
+    {
+      XBMC->CloseFile(cacheFileHandle);
+
+      if (bytesRead > 0 && cacheWritten)
+        CommitTempFile(tempCachedPath, cachedPath);
+      else
+        XBMC->DeleteFile(tempCachedPath.c_str());
     }
-    return contents.length();
+
+    return bytesRead;
+  }
+
+  return FileUtils::StreamFileContents(cachedPath, dataHandler, options);
+}
+
+bool FileUtils::CommitTempFile(const std::string& tempFilePath, const std::string& filePath)
+{
+  // The user path is a local directory so a rename replaces the file in one step.
+  // rename() doesn't replace an existing file on Windows, it has to be deleted first.
+#ifdef TARGET_WINDOWS
+  XBMC->DeleteFile(filePath.c_str());
+#endif
+  if (std::rename(tempFilePath.c_str(), filePath.c_str()) == 0)
+    return true;
+
+  // Otherwise copy it through the VFS
+  void* fileHandle = XBMC->OpenFileForWrite(filePath.c_str(), true);
+  bool written = fileHandle != nullptr;
+  if (fileHandle)
+  {
+    StreamFileContents(tempFilePath, [&](const char* data, size_t length)
+    {
+      written &= XBMC->WriteFile(fileHandle, data, length) == static_cast<ssize_t>(length);
+    });
+    XBMC->CloseFile(fileHandle);
   }
 
-  return FileUtils::GetFileContents(cachedPath, contents);
-}
\ No newline at end of file
+  if (!written)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Unable to replace '%s'", __FUNCTION__, filePath.c_str());
+    XBMC->DeleteFile(filePath.c_str());
+  }
+
+  XBMC->DeleteFile(tempFilePath.c_str());
+  return written;
+}
@@ -23,12 +23,42 @@
 
 #include "p8-platform/os.h"
 
+#include "CancellationToken.h"
+
+#include <chrono>
+#include <functional>
 #include <string>
 
 namespace iptvsimple
 {
   namespace utilities
   {
+    /**
+     * Called with each block of data as it is read from a file
+     */
+    typedef std::function<void(const char* data, size_t length)> FileDataHandler;
+
+    /**
+     * Called after each block of data is read with the total read so far
+     */
+    typedef std::function<void(size_t totalBytesRead)> FetchProgressHandler;
+
+    /**
+     * Limits on a fetch. Both the token and the stall timeout are checked between reads so an
+     * aborted fetch ends within one read, a read that blocks is left to Kodi's own timeouts.
+     * The stall timeout is the longest wait for a single read, a slow but steady fetch never hits it.
+     */
+    struct FetchOptions
+    {
+      const CancellationToken* cancellationToken = nullptr;
+      std::chrono::steady_clock::duration stallTimeout = std::chrono::steady_clock::duration::max();
+      FetchProgressHandler progressHandler;
+    };
+
+    static const int DEFAULT_FETCH_STALL_TIMEOUT_SECS = 300;
+    static const std::string TEMP_FILE_EXTENSION = ".tmp";
+    static const size_t FETCH_PROGRESS_LOG_INTERVAL_BYTES = 4 * 1024 * 1024;
+
     class FileUtils
     {
     public:
@@ -38,7 +68,22 @@ namespace iptvsimple
       static int GetFileContents(const std::string& url, std::string& content);
       static bool GzipInflate(const std::string& compressedBytes, std::string& uncompressedBytes);
       static int GetCachedFileContents(const std::string& cachedName, const std::string& filePath,
-                                       std::string& content, const bool useCache = false);
+                                       std::string& content, const bool useCache = false,
+                                       const FetchOptions& options = FetchOptions());
+      static FetchOptions CreateFetchOptions(const CancellationToken& cancellationToken, const std::string& description,
+                                             int stallTimeoutSecs = DEFAULT_FETCH_STALL_TIMEOUT_SECS);
+      static int StreamFileContents(const std::string& url, const FileDataHandler& dataHandler,
+                                    const FetchOptions& options = FetchOptions());
+      static int StreamCachedFileContents(const std::string& cachedName, const std::string& filePath,
+                                          const FileDataHandler& dataHandler, const bool useCache = false,
+                                          const FetchOptions& options = FetchOptions());
+      /**
+       * Replaces the file with a completely written temporary file, which is removed either way
+       */
+      static bool CommitTempFile(const std::string& tempFilePath, const std::string& filePath);
+
+    private:
+      static const unsigned int READ_CHUNK_SIZE = 16384;
     };
   } // namespace utilities
 } // namespace iptvsimple
@@ -0,0 +1,52 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace iptvsimple
+{
+  namespace utilities
+  {
+    class HashUtils
+    {
+    public:
+      static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+      /**
+       * 64 bit FNV-1a hash which can be calculated incrementally, pass the
+       * result of the previous call as the hash to continue from.
+       */
+      static uint64_t Fnv1aHash(const char* data, size_t length, uint64_t hash = FNV_OFFSET_BASIS)
+      {
+        for (size_t i = 0; i < length; i++)
+        {
+          hash ^= static_cast<unsigned char>(data[i]);
+          hash *= 1099511628211ULL;
+        }
+
+        return hash;
+      }
+    };
+  } // namespace utilities
+} // namespace iptvsimple
@@ -0,0 +1,91 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace iptvsimple
+{
+  namespace utilities
+  {
+    /**
+     * Estimates of the heap memory held by containers. Allocator overhead is not included so
+     * the values are a lower bound, good enough to tell which structure is growing.
+     */
+    class MemoryUtils
+    {
+    public:
+      static size_t GetHeapSize(const std::string& value)
+      {
+        // A default constructed string has the capacity of the small string buffer, beyond that it is on the heap
+        static const size_t smallStringCapacity = std::string().capacity();
+        return value.capacity() > smallStringCapacity ? value.capacity() + 1 : 0;
+      }
+
+      template<typename T>
+      static typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value, size_t>::type GetHeapSize(const T&)
+      {
+        return 0;
+      }
+
+      /**
+       * Only the storage of the vector, the heap memory of the elements is up to the caller
+       */
+      template<typename T>
+      static size_t GetHeapSize(const std::vector<T>& values)
+      {
+        return values.capacity() * sizeof(T);
+      }
+
+      template<typename K, typename V>
+      static size_t GetHeapSize(const std::unordered_map<K, V>& values)
+      {
+        // Each node holds the pair, the next pointer and the cached hash
+        size_t size = values.bucket_count() * sizeof(void*) +
+                      values.size() * (sizeof(typename std::unordered_map<K, V>::value_type) + sizeof(void*) + sizeof(size_t));
+        for (const auto& value : values)
+          size += GetHeapSize(value.first) + GetHeapSize(value.second);
+        return size;
+      }
+
+      template<typename K, typename V>
+      static size_t GetHeapSize(const std::map<K, V>& values)
+      {
+        // Each node holds the pair, three pointers and the colour
+        size_t size = values.size() * (sizeof(typename std::map<K, V>::value_type) + 4 * sizeof(void*));
+        for (const auto& value : values)
+          size += GetHeapSize(value.first) + GetHeapSize(value.second);
+        return size;
+      }
+
+      /**
+       * The high water mark of the resident set size of the process in bytes, 0 if it is not available
+       */
+      static size_t GetPeakResidentSetSize();
+    };
+  } // namespace utilities
+} // namespace iptvsimple
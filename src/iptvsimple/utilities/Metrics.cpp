@@ -0,0 +1,241 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Metrics.h"
+
+#include "Logger.h"
+#include "../../client.h"
+
+#include <algorithm>
+#include <cinttypes>
+
+using namespace iptvsimple;
+using namespace iptvsimple::utilities;
+
+namespace
+{
+
+const char* COUNTER_NAMES[] =
+{
+  "download_bytes",
+  "epg_entries_accepted",
+  "epg_entries_rejected",
+};
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == static_cast<int>(MetricCounter::COUNT), "A name is required for each counter");
+
+const char* TIMER_NAMES[] =
+{
+  "download_us",
+  "inflate_us",
+  "xml_parse_us",
+  "lock_wait_us",
+  "lock_hold_us",
+  "get_epg_for_channel_us",
+  "get_channels_us",
+  "get_channel_stream_properties_us",
+};
+static_assert(sizeof(TIMER_NAMES) / sizeof(TIMER_NAMES[0]) == static_cast<int>(MetricTimer::COUNT), "A name is required for each timer");
+
+const char* GAUGE_NAMES[] =
+{
+  "channels_bytes",
+  "channel_groups_bytes",
+  "epg_bytes",
+  "xmltv_download_bytes",
+  "xmltv_inflated_bytes",
+  "xmltv_dom_bytes",
+  "peak_rss_bytes",
+};
+static_assert(sizeof(GAUGE_NAMES) / sizeof(GAUGE_NAMES[0]) == static_cast<int>(MetricGauge::COUNT), "A name is required for each gauge");
+
+int BucketFor(uint64_t value)
+{
+  int bucket = 0;
+  while (value > 0 && bucket < MetricHistogram::BUCKET_COUNT - 1)
+  {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+} // unnamed namespace
+
+void MetricHistogram::Record(uint64_t value)
+{
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  m_buckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t max = m_max.load(std::memory_order_relaxed);
+  while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    ;
+}
+
+void MetricHistogram::Reset()
+{
+  m_count = 0;
+  m_sum = 0;
+  m_max = 0;
+  for (auto& bucket : m_buckets)
+    bucket = 0;
+}
+
+uint64_t MetricHistogram::GetPercentile(int percentile) const
+{
+  const uint64_t count = m_count;
+  if (count == 0)
+    return 0;
+
+  const uint64_t rank = (count * percentile + 99) / 100;
+  uint64_t seen = 0;
+  for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+  {
+    seen += m_buckets[bucket];
+    if (seen >= rank)
+      return std::min(bucket == 0 ? 0 : (UINT64_C(1) << bucket) - 1, GetMax());
+  }
+
+  return GetMax();
+}
+
+void Metrics::SetEnabled(bool enabled)
+{
+  if (enabled != m_enabled)
+    Logger::Log(LEVEL_NOTICE, "%s - Metrics collection %s", __FUNCTION__, enabled ? "enabled" : "disabled");
+
+  m_enabled = enabled;
+}
+
+void Metrics::SetGauge(MetricGauge gauge, uint64_t value)
+{
+  m_gauges[static_cast<int>(gauge)].store(value, std::memory_order_relaxed);
+
+  std::atomic<uint64_t>& peak = m_gaugePeaks[static_cast<int>(gauge)];
+  uint64_t currentPeak = peak.load(std::memory_order_relaxed);
+  while (value > currentPeak && !peak.compare_exchange_weak(currentPeak, value, std::memory_order_relaxed))
+    ;
+}
+
+void Metrics::Reset()
+{
+  for (auto& counter : m_counters)
+    counter = 0;
+  for (auto& gauge : m_gauges)
+    gauge = 0;
+  for (auto& gaugePeak : m_gaugePeaks)
+    gaugePeak = 0;
+  for (auto& timer : m_timers)
+    timer.Reset();
+}
+
+void Metrics::LogSummary() const
+{
+  if (!m_enabled)
+  {
+    Logger::Log(LEVEL_NOTICE, "%s - Metrics collection is disabled in the addon settings", __FUNCTION__);
+    return;
+  }
+
+  for (int i = 0; i < static_cast<int>(MetricCounter::COUNT); i++)
+    Logger::Log(LEVEL_NOTICE, "%s - %s: %" PRIu64, __FUNCTION__, COUNTER_NAMES[i], m_counters[i].load());
+
+  for (int i = 0; i < static_cast<int>(MetricGauge::COUNT); i++)
+    Logger::Log(LEVEL_NOTICE, "%s - %s: %" PRIu64 ", peak %" PRIu64, __FUNCTION__, GAUGE_NAMES[i], m_gauges[i].load(), m_gaugePeaks[i].load());
+
+  for (int i = 0; i < static_cast<int>(MetricTimer::COUNT); i++)
+  {
+    const MetricHistogram& timer = m_timers[i];
+    if (timer.GetCount() == 0)
+      continue;
+
+    Logger::Log(LEVEL_NOTICE, "%s - %s: count %" PRIu64 ", mean %" PRIu64 ", p50 <= %" PRIu64 ", p99 <= %" PRIu64 ", max %" PRIu64,
+                __FUNCTION__, TIMER_NAMES[i], timer.GetCount(), timer.GetSum() / timer.GetCount(),
+                timer.GetPercentile(50), timer.GetPercentile(99), timer.GetMax());
+  }
+}
+
+std::string Metrics::ToJson() const
+{
+  std::string json = "{\n  \"counters\": {";
+
+  for (int i = 0; i < static_cast<int>(MetricCounter::COUNT); i++)
+  {
+    json += i == 0 ? "\n" : ",\n";
+    json += "    \"" + std::string(COUNTER_NAMES[i]) + "\": " + std::to_string(m_counters[i].load());
+  }
+
+  json += "\n  },\n  \"gauges\": {";
+
+  for (int i = 0; i < static_cast<int>(MetricGauge::COUNT); i++)
+  {
+    json += i == 0 ? "\n" : ",\n";
+    json += "    \"" + std::string(GAUGE_NAMES[i]) + "\": {\"current\": " + std::to_string(m_gauges[i].load()) +
+            ", \"peak\": " + std::to_string(m_gaugePeaks[i].load()) + "}";
+  }
+
+  json += "\n  },\n  \"timers\": {";
+
+  for (int i = 0; i < static_cast<int>(MetricTimer::COUNT); i++)
+  {
+    const MetricHistogram& timer = m_timers[i];
+
+    json += i == 0 ? "\n" : ",\n";
+    json += "    \"" + std::string(TIMER_NAMES[i]) + "\": {";
+    json += "\"count\": " + std::to_string(timer.GetCount());
+    json += ", \"sum\": " + std::to_string(timer.GetSum());
+    json += ", \"max\": " + std::to_string(timer.GetMax());
+    json += ", \"p50\": " + std::to_string(timer.GetPercentile(50));
+    json += ", \"p90\": " + std::to_string(timer.GetPercentile(90));
+    json += ", \"p99\": " + std::to_string(timer.GetPercentile(99));
+    json += ", \"buckets\": [";
+    for (int bucket = 0; bucket < MetricHistogram::BUCKET_COUNT; bucket++)
+    {
+      if (bucket > 0)
+        json += ", ";
+      json += std::to_string(timer.GetBucketCount(bucket));
+    }
+    json += "]}";
+  }
+
+  json += "\n  }\n}\n";
+
+  return json;
+}
+
+bool Metrics::WriteJsonFile(const std::string& filePath) const
+{
+  const std::string json = ToJson();
+
+  void* fileHandle = XBMC->OpenFileForWrite(filePath.c_str(), true);
+  if (!fileHandle)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Unable to write metrics file '%s'", __FUNCTION__, filePath.c_str());
+    return false;
+  }
+
+  XBMC->WriteFile(fileHandle, json.data(), json.length());
+  XBMC->CloseFile(fileHandle);
+
+  Logger::Log(LEVEL_NOTICE, "%s - Metrics written to '%s'", __FUNCTION__, filePath.c_str());
+  return true;
+}
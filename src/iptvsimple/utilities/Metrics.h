@@ -0,0 +1,220 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "p8-platform/threads/mutex.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace iptvsimple
+{
+  namespace utilities
+  {
+    static const std::string METRICS_FILE_NAME = "metrics.json";
+
+    enum class MetricCounter
+      : int
+    {
+      DOWNLOAD_BYTES = 0,
+      EPG_ENTRIES_ACCEPTED,
+      EPG_ENTRIES_REJECTED,
+      COUNT // not a counter, the number of counters
+    };
+
+    enum class MetricTimer
+      : int
+    {
+      DOWNLOAD = 0,
+      INFLATE,
+      XML_PARSE,
+      LOCK_WAIT,
+      LOCK_HOLD,
+      GET_EPG_FOR_CHANNEL,
+      GET_CHANNELS,
+      GET_CHANNEL_STREAM_PROPERTIES,
+      COUNT // not a timer, the number of timers
+    };
+
+    enum class MetricGauge
+      : int
+    {
+      CHANNELS_BYTES = 0,
+      CHANNEL_GROUPS_BYTES,
+      EPG_BYTES,
+      XMLTV_DOWNLOAD_BYTES,
+      XMLTV_INFLATED_BYTES,
+      XMLTV_DOM_BYTES,
+      PEAK_RSS_BYTES,
+      COUNT // not a gauge, the number of gauges
+    };
+
+    /**
+     * Durations in microseconds, bucket n counts values below 2^n
+     */
+    class MetricHistogram
+    {
+    public:
+      static const int BUCKET_COUNT = 32;
+
+      void Record(uint64_t value);
+      void Reset();
+
+      uint64_t GetCount() const { return m_count; }
+      uint64_t GetSum() const { return m_sum; }
+      uint64_t GetMax() const { return m_max; }
+      uint64_t GetBucketCount(int bucket) const { return m_buckets[bucket]; }
+      /**
+       * The upper bound of the bucket holding the percentile, the buckets are all that is kept
+       */
+      uint64_t GetPercentile(int percentile) const;
+
+    private:
+      std::atomic<uint64_t> m_count{0};
+      std::atomic<uint64_t> m_sum{0};
+      std::atomic<uint64_t> m_max{0};
+      std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets{};
+    };
+
+    /**
+     * Counters and timings of loading and of the calls from Kodi. Collection is switched on by a setting,
+     * when off recording is a single relaxed load so the calls can stay in place in the hot paths.
+     */
+    class Metrics
+    {
+    public:
+      static Metrics& GetInstance()
+      {
+        static Metrics metrics;
+        return metrics;
+      }
+
+      static bool IsEnabled() { return GetInstance().m_enabled.load(std::memory_order_relaxed); }
+      static void Add(MetricCounter counter, uint64_t value)
+      {
+        if (IsEnabled())
+          GetInstance().m_counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+      }
+      /**
+       * Sets the current value, the highest value set is kept alongside it
+       */
+      static void Set(MetricGauge gauge, uint64_t value)
+      {
+        if (IsEnabled())
+          GetInstance().SetGauge(gauge, value);
+      }
+      static uint64_t Get(MetricGauge gauge) { return GetInstance().m_gauges[static_cast<int>(gauge)]; }
+      static void Record(MetricTimer timer, std::chrono::steady_clock::duration duration)
+      {
+        if (IsEnabled())
+          GetInstance().m_timers[static_cast<int>(timer)].Record(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+      }
+      static const MetricHistogram& Get(MetricTimer timer) { return GetInstance().m_timers[static_cast<int>(timer)]; }
+
+      void SetEnabled(bool enabled);
+      void Reset();
+
+      void LogSummary() const;
+      std::string ToJson() const;
+      bool WriteJsonFile(const std::string& filePath) const;
+
+    private:
+      Metrics() = default;
+
+      void SetGauge(MetricGauge gauge, uint64_t value);
+
+      Metrics(Metrics const&) = delete;
+      void operator=(Metrics const&) = delete;
+
+      std::atomic_bool m_enabled{false};
+      std::array<std::atomic<uint64_t>, static_cast<int>(MetricCounter::COUNT)> m_counters{};
+      std::array<MetricHistogram, static_cast<int>(MetricTimer::COUNT)> m_timers;
+      std::array<std::atomic<uint64_t>, static_cast<int>(MetricGauge::COUNT)> m_gauges{};
+      std::array<std::atomic<uint64_t>, static_cast<int>(MetricGauge::COUNT)> m_gaugePeaks{};
+    };
+
+    /**
+     * Records the time from construction to destruction
+     */
+    class ScopedMetricTimer
+    {
+    public:
+      explicit ScopedMetricTimer(MetricTimer timer)
+        : m_timer(timer), m_enabled(Metrics::IsEnabled())
+      {
+        if (m_enabled)
+          m_start = std::chrono::steady_clock::now();
+      }
+
+      ~ScopedMetricTimer()
+      {
+        if (m_enabled)
+          Metrics::Record(m_timer, std::chrono::steady_clock::now() - m_start);
+      }
+
+    private:
+      ScopedMetricTimer(ScopedMetricTimer const&) = delete;
+      void operator=(ScopedMetricTimer const&) = delete;
+
+      const MetricTimer m_timer;
+      const bool m_enabled;
+      std::chrono::steady_clock::time_point m_start;
+    };
+
+    /**
+     * A P8PLATFORM::CLockObject that records how long it waited for the mutex and how long it held it
+     */
+    class TimedLockObject
+    {
+    public:
+      explicit TimedLockObject(P8PLATFORM::CMutex& mutex)
+        : m_enabled(Metrics::IsEnabled()),
+          m_waitStart(m_enabled ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()),
+          m_lock(mutex)
+      {
+        if (m_enabled)
+        {
+          m_holdStart = std::chrono::steady_clock::now();
+          Metrics::Record(MetricTimer::LOCK_WAIT, m_holdStart - m_waitStart);
+        }
+      }
+
+      ~TimedLockObject()
+      {
+        if (m_enabled)
+          Metrics::Record(MetricTimer::LOCK_HOLD, std::chrono::steady_clock::now() - m_holdStart);
+      }
+
+    private:
+      TimedLockObject(TimedLockObject const&) = delete;
+      void operator=(TimedLockObject const&) = delete;
+
+      const bool m_enabled;
+      const std::chrono::steady_clock::time_point m_waitStart;
+      P8PLATFORM::CLockObject m_lock;
+      std::chrono::steady_clock::time_point m_holdStart;
+    };
+  } // namespace utilities
+} // namespace iptvsimple
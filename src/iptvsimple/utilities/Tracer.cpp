@@ -0,0 +1,126 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Tracer.h"
+
+#include "Logger.h"
+#include "../../client.h"
+
+using namespace iptvsimple;
+using namespace iptvsimple::utilities;
+
+namespace
+{
+
+// Taken when the library is loaded so spans that started before tracing was switched on are still after it
+const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+} // unnamed namespace
+
+void Tracer::SetEnabled(bool enabled)
+{
+  if (enabled != m_enabled)
+    Logger::Log(LEVEL_NOTICE, "%s - Tracing %s", __FUNCTION__, enabled ? "enabled" : "disabled");
+
+  m_enabled = enabled;
+}
+
+void Tracer::SetThreadName(const char* name)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_threadNames[GetThreadId()] = name;
+}
+
+int Tracer::GetThreadId()
+{
+  // Small ids keep the trace readable, the mutex is already held by the caller
+  auto threadIdPair = m_threadIds.find(std::this_thread::get_id());
+  if (threadIdPair != m_threadIds.end())
+    return threadIdPair->second;
+
+  const int threadId = m_threadIds.size() + 1;
+  m_threadIds.insert({std::this_thread::get_id(), threadId});
+  return threadId;
+}
+
+void Tracer::AddSpan(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Tracing left on indefinitely must not grow without bounds
+  if (m_spans.size() >= MAX_SPANS)
+  {
+    if (!m_spansDropped)
+      Logger::Log(LEVEL_ERROR, "%s - Trace is full, dropping further spans", __FUNCTION__);
+    m_spansDropped = true;
+    return;
+  }
+
+  Span span;
+  span.name = name;
+  span.threadId = GetThreadId();
+  span.startMicros = std::chrono::duration_cast<std::chrono::microseconds>(start - traceEpoch).count();
+  span.durationMicros = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+  m_spans.emplace_back(span);
+}
+
+bool Tracer::WriteFile(const std::string& filePath) const
+{
+  std::string json = "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    json.reserve(json.size() + (m_threadNames.size() + m_spans.size()) * 100);
+
+    bool first = true;
+    for (const auto& threadNamePair : m_threadNames)
+    {
+      json += first ? "" : ",\n";
+      json += "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " + std::to_string(threadNamePair.first) +
+              ", \"args\": {\"name\": \"" + threadNamePair.second + "\"}}";
+      first = false;
+    }
+
+    for (const Span& span : m_spans)
+    {
+      json += first ? "" : ",\n";
+      json += "{\"name\": \"" + std::string(span.name) + "\", \"cat\": \"pvr\", \"ph\": \"X\", \"pid\": 1, \"tid\": " +
+              std::to_string(span.threadId) + ", \"ts\": " + std::to_string(span.startMicros) +
+              ", \"dur\": " + std::to_string(span.durationMicros) + "}";
+      first = false;
+    }
+  }
+  json += "\n]}\n";
+
+  void* fileHandle = XBMC->OpenFileForWrite(filePath.c_str(), true);
+  if (!fileHandle)
+  {
+    Logger::Log(LEVEL_ERROR, "%s - Unable to write trace file '%s'", __FUNCTION__, filePath.c_str());
+    return false;
+  }
+
+  XBMC->WriteFile(fileHandle, json.data(), json.length());
+  XBMC->CloseFile(fileHandle);
+
+  Logger::Log(LEVEL_NOTICE, "%s - Trace written to '%s'", __FUNCTION__, filePath.c_str());
+  return true;
+}
@@ -0,0 +1,126 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace iptvsimple
+{
+  namespace utilities
+  {
+    static const std::string TRACE_FILE_NAME = "trace.json";
+
+    /**
+     * Records spans in memory and writes them as a Chrome trace_event file that can be opened
+     * in chrome://tracing or Perfetto. Switched on by a hidden setting, when off a span is a single relaxed load.
+     */
+    class Tracer
+    {
+    public:
+      static Tracer& GetInstance()
+      {
+        static Tracer tracer;
+        return tracer;
+      }
+
+      static bool IsEnabled() { return GetInstance().m_enabled.load(std::memory_order_relaxed); }
+
+      void SetEnabled(bool enabled);
+      /**
+       * Names the calling thread in the trace, the name must be a literal or otherwise outlive the tracer
+       */
+      void SetThreadName(const char* name);
+      /**
+       * The name must be a literal or otherwise outlive the tracer
+       */
+      void AddSpan(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+      bool WriteFile(const std::string& filePath) const;
+
+    private:
+      static const size_t MAX_SPANS = 1000000;
+
+      struct Span
+      {
+        const char* name;
+        int threadId;
+        int64_t startMicros;
+        int64_t durationMicros;
+      };
+
+      Tracer() = default;
+
+      Tracer(Tracer const&) = delete;
+      void operator=(Tracer const&) = delete;
+
+      int GetThreadId();
+
+      std::atomic_bool m_enabled{false};
+
+      mutable std::mutex m_mutex;
+      std::vector<Span> m_spans;
+      std::unordered_map<std::thread::id, int> m_threadIds;
+      std::unordered_map<int, const char*> m_threadNames;
+      bool m_spansDropped = false;
+    };
+
+    /**
+     * Traces the time from construction to destruction, the name must be a literal or __FUNCTION__
+     */
+    class ScopedTraceSpan
+    {
+    public:
+      explicit ScopedTraceSpan(const char* name)
+        : m_name(name), m_enabled(Tracer::IsEnabled())
+      {
+        if (m_enabled)
+          m_start = std::chrono::steady_clock::now();
+      }
+
+      /**
+       * For spans that started before tracing could be switched on
+       */
+      ScopedTraceSpan(const char* name, std::chrono::steady_clock::time_point start)
+        : m_name(name), m_enabled(Tracer::IsEnabled()), m_start(start) {}
+
+      ~ScopedTraceSpan()
+      {
+        if (m_enabled)
+          Tracer::GetInstance().AddSpan(m_name, m_start, std::chrono::steady_clock::now());
+      }
+
+    private:
+      ScopedTraceSpan(ScopedTraceSpan const&) = delete;
+      void operator=(ScopedTraceSpan const&) = delete;
+
+      const char* m_name;
+      const bool m_enabled;
+      std::chrono::steady_clock::time_point m_start;
+    };
+  } // namespace utilities
+} // namespace iptvsimple
@@ -0,0 +1,137 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+  /**
+   * Heap allocations made through operator new since the program started, on any thread
+   */
+  uint64_t GetAllocationCount();
+
+  /**
+   * Passed to each benchmark run. The code to measure goes in a while (state.KeepRunning())
+   * loop, anything before the loop is setup and is not timed.
+   */
+  class State
+  {
+  public:
+    State(int64_t range, size_t iterations) : m_range(range), m_iterations(iterations) {}
+
+    /**
+     * The input size the benchmark is run with
+     */
+    int64_t GetRange() const { return m_range; }
+
+    bool KeepRunning()
+    {
+      if (m_completedIterations == 0 && !m_started)
+      {
+        m_started = true;
+        m_startAllocationCount = GetAllocationCount();
+        m_start = std::chrono::steady_clock::now();
+      }
+      else
+      {
+        m_completedIterations++;
+      }
+
+      if (m_completedIterations < m_iterations)
+        return true;
+
+      m_end = std::chrono::steady_clock::now();
+      m_allocations = GetAllocationCount() - m_startAllocationCount;
+      return false;
+    }
+
+    /**
+     * How many items (lines, lookups, bytes...) one iteration processes, so runs with different ranges compare
+     */
+    void SetItemsPerIteration(size_t items) { m_itemsPerIteration = items; }
+    size_t GetItemsPerIteration() const { return m_itemsPerIteration; }
+
+    /**
+     * Fails the run when the timed loop makes more heap allocations per item than this,
+     * so a change that adds copies to a path that should only move them stands out
+     */
+    void SetMaxAllocationsPerItem(double allocations) { m_maxAllocationsPerItem = allocations; }
+    double GetMaxAllocationsPerItem() const { return m_maxAllocationsPerItem; }
+    uint64_t GetAllocations() const { return m_allocations; }
+
+    size_t GetIterations() const { return m_iterations; }
+    std::chrono::nanoseconds GetElapsed() const { return m_end - m_start; }
+
+  private:
+    int64_t m_range;
+    size_t m_iterations;
+    size_t m_completedIterations = 0;
+    size_t m_itemsPerIteration = 1;
+    double m_maxAllocationsPerItem = -1;
+    uint64_t m_startAllocationCount = 0;
+    uint64_t m_allocations = 0;
+    bool m_started = false;
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::time_point m_end;
+  };
+
+  typedef void (*BenchmarkFunction)(State& state);
+
+  struct Benchmark
+  {
+    std::string name;
+    std::vector<int64_t> ranges;
+    BenchmarkFunction function;
+  };
+
+  std::vector<Benchmark>& GetBenchmarks();
+
+  /**
+   * Declare one at namespace scope in the file holding the benchmark to add it to the suite
+   */
+  struct Registration
+  {
+    Registration(const char* name, std::vector<int64_t> ranges, BenchmarkFunction function)
+    {
+      GetBenchmarks().push_back({name, std::move(ranges), function});
+    }
+  };
+
+  /**
+   * Stops the compiler discarding a result that is otherwise unused
+   */
+  template<typename T>
+  inline void DoNotOptimize(const T& value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+  }
+} // namespace benchmarks
@@ -0,0 +1,83 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "iptvsimple/ChannelGroups.h"
+#include "iptvsimple/Channels.h"
+#include "iptvsimple/Epg.h"
+#include "iptvsimple/PlaylistLoader.h"
+
+#include <string>
+#include <vector>
+
+namespace iptvsimple
+{
+  /**
+   * Forwards to the private hot paths of the classes that declare it a friend
+   */
+  class BenchmarkAccess
+  {
+  public:
+    static std::string ReadMarkerValue(const std::string& line, const std::string& markerName)
+    {
+      return PlaylistLoader::ReadMarkerValue(line, markerName);
+    }
+
+    static std::string ParseIntoChannel(PlaylistLoader& playlistLoader, const std::string& line, data::Channel& channel,
+                                        std::vector<int>& groupIdList, int epgTimeShift)
+    {
+      return playlistLoader.ParseIntoChannel(line, channel, groupIdList, epgTimeShift);
+    }
+
+    /**
+     * Parses a whole playlist held in memory into the given channels and groups, as a load does
+     */
+    static void ParsePlaylist(PlaylistLoader& playlistLoader, const std::string& data, Channels& channels,
+                              ChannelGroups& channelGroups)
+    {
+      PlaylistLoader::ParseState state(channels, channelGroups);
+      std::string line;
+      playlistLoader.ParseLines(data, data.length() - 1, line, state);
+    }
+
+    static int GenerateChannelId(const Channels& channels, const std::string& channelName, const std::string& streamUrl)
+    {
+      return channels.GenerateChannelId(channelName, streamUrl);
+    }
+
+    static bool LoadChannelEpgs(Epg& epg, rapidxml::xml_node<>* rootElement)
+    {
+      return epg.LoadChannelEpgs(rootElement);
+    }
+
+    static data::ChannelEpg* FindEpgForChannel(Epg& epg, const std::string& id)
+    {
+      return epg.FindEpgForChannel(id);
+    }
+
+    static data::ChannelEpg* FindEpgForChannel(Epg& epg, const data::Channel& channel)
+    {
+      return epg.FindEpgForChannel(channel);
+    }
+  };
+} // namespace iptvsimple
@@ -0,0 +1,107 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "BenchmarkData.h"
+
+#include <ctime>
+#include <vector>
+
+using namespace benchmarks;
+using namespace iptvsimple;
+using namespace iptvsimple::data;
+
+namespace
+{
+
+std::string FormatXmltvTime(time_t time)
+{
+  char buffer[32];
+  strftime(buffer, sizeof(buffer), "%Y%m%d%H%M%S +0000", gmtime(&time));
+  return buffer;
+}
+
+} // unnamed namespace
+
+std::string benchmarks::GetChannelName(int index)
+{
+  return "Channel " + std::to_string(index);
+}
+
+std::string benchmarks::GetTvgId(int index)
+{
+  return "channel." + std::to_string(index) + ".example";
+}
+
+std::string benchmarks::GetStreamUrl(int index)
+{
+  return "http://streams.example/live/" + std::to_string(index) + ".ts";
+}
+
+void benchmarks::AddChannels(Channels& channels, ChannelGroups& channelGroups, int amount)
+{
+  std::vector<int> groupIdList;
+  channels.ReserveChannels(amount);
+
+  for (int i = 0; i < amount; i++)
+  {
+    Channel channel;
+    channel.SetChannelNumber(i + 1);
+    channel.SetChannelName(GetChannelName(i));
+    channel.SetTvgId(GetTvgId(i));
+    channel.SetTvgName("Channel_" + std::to_string(i));
+    channel.SetStreamURL(GetStreamUrl(i));
+
+    channels.AddChannel(std::move(channel), groupIdList, channelGroups);
+  }
+}
+
+std::string benchmarks::CreateXmltv(int channelsAmount, int programmesPerChannel, time_t startTime)
+{
+  std::string xmltv = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<tv>\n";
+
+  for (int i = 0; i < channelsAmount; i++)
+  {
+    xmltv += "  <channel id=\"" + GetTvgId(i) + "\">\n";
+    xmltv += "    <display-name>" + GetChannelName(i) + "</display-name>\n";
+    xmltv += "    <icon src=\"http://logos.example/" + std::to_string(i) + ".png\"/>\n";
+    xmltv += "  </channel>\n";
+  }
+
+  for (int i = 0; i < channelsAmount; i++)
+  {
+    for (int j = 0; j < programmesPerChannel; j++)
+    {
+      const time_t programmeStart = startTime + j * 3600;
+      xmltv += "  <programme start=\"" + FormatXmltvTime(programmeStart) + "\" stop=\"" + FormatXmltvTime(programmeStart + 3600) +
+               "\" channel=\"" + GetTvgId(i) + "\">\n";
+      xmltv += "    <title>Programme " + std::to_string(j) + "</title>\n";
+      xmltv += "    <sub-title>Episode " + std::to_string(j) + "</sub-title>\n";
+      xmltv += "    <desc>The description of programme " + std::to_string(j) + " on " + GetChannelName(i) + ".</desc>\n";
+      xmltv += "    <category>Documentary</category>\n";
+      xmltv += "  </programme>\n";
+    }
+  }
+
+  xmltv += "</tv>\n";
+
+  return xmltv;
+}
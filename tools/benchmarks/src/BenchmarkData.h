@@ -0,0 +1,45 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "iptvsimple/ChannelGroups.h"
+#include "iptvsimple/Channels.h"
+
+#include <string>
+
+namespace benchmarks
+{
+  /**
+   * Inputs shared by the benchmarks, channel i has the same names and ids in the playlist and the XMLTV
+   */
+  std::string GetChannelName(int index);
+  std::string GetTvgId(int index);
+  std::string GetStreamUrl(int index);
+
+  void AddChannels(iptvsimple::Channels& channels, iptvsimple::ChannelGroups& channelGroups, int amount);
+
+  /**
+   * An XMLTV document with the given channels and an hour long programme for each of them, starting at the given time
+   */
+  std::string CreateXmltv(int channelsAmount, int programmesPerChannel, time_t startTime);
+} // namespace benchmarks
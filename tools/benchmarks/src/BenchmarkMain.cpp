@@ -0,0 +1,285 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Runs the microbenchmarks registered in the other files of this directory. Each one is
+ * run for every range it lists, the iterations are scaled until a run takes the minimum
+ * time and the run is then repeated. The results are written as JSON to compare branches.
+ * A benchmark going over the allocations per item it allows fails the run.
+ */
+
+#include "Benchmark.h"
+
+#include "FakeKodi.h"
+#include "client.h"
+
+#include "p8-platform/util/util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace benchmarks;
+
+namespace
+{
+
+struct RunnerOptions
+{
+  std::string filter;
+  std::string outputFile;
+  int minTimeMs = 200;
+  int repetitions = 5;
+  bool list = false;
+};
+
+struct Result
+{
+  std::string benchmarkName;
+  int64_t range;
+  size_t iterations;
+  size_t itemsPerIteration;
+  std::vector<double> nsPerIteration;
+  double allocationsPerItem;
+  double maxAllocationsPerItem;
+};
+
+void PrintUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --help                    Show this help\n"
+          "  --list                    List the benchmarks and their ranges\n"
+          "  --filter <text>           Only run benchmarks with a name containing the text\n"
+          "  --out <file>              Write the JSON results to a file instead of stdout\n"
+          "  --min-time-ms <ms>        Minimum time of each repetition, default 200\n"
+          "  --repetitions <count>     Repetitions of each benchmark and range, default 5\n",
+          program);
+}
+
+bool ParseOptions(int argc, char* argv[], RunnerOptions& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string option = argv[i];
+    if (option == "--list")
+    {
+      options.list = true;
+      continue;
+    }
+    else if (option == "--help" || i + 1 >= argc)
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+
+    const std::string value = argv[++i];
+
+    if (option == "--filter")
+      options.filter = value;
+    else if (option == "--out")
+      options.outputFile = value;
+    else if (option == "--min-time-ms")
+      options.minTimeMs = std::max(1, std::atoi(value.c_str()));
+    else if (option == "--repetitions")
+      options.repetitions = std::max(1, std::atoi(value.c_str()));
+    else
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+double RunOnce(const Benchmark& benchmark, int64_t range, size_t iterations, Result& result)
+{
+  State state(range, iterations);
+  benchmark.function(state);
+  result.itemsPerIteration = state.GetItemsPerIteration();
+  result.allocationsPerItem = static_cast<double>(state.GetAllocations()) / (iterations * state.GetItemsPerIteration());
+  result.maxAllocationsPerItem = state.GetMaxAllocationsPerItem();
+
+  return static_cast<double>(state.GetElapsed().count());
+}
+
+Result Run(const Benchmark& benchmark, int64_t range, const RunnerOptions& options)
+{
+  Result result{benchmark.name, range, 1, 1, {}, 0, -1};
+  const double minTimeNs = options.minTimeMs * 1e6;
+
+  // Grow the iterations until a run takes the minimum time, aiming a little over it
+  double elapsedNs = RunOnce(benchmark, range, result.iterations, result);
+  while (elapsedNs < minTimeNs)
+  {
+    const double scale = elapsedNs > 0 ? minTimeNs * 1.2 / elapsedNs : 10.0;
+    result.iterations = static_cast<size_t>(result.iterations * std::min(std::max(scale, 1.5), 10.0));
+    elapsedNs = RunOnce(benchmark, range, result.iterations, result);
+  }
+
+  result.nsPerIteration.push_back(elapsedNs / result.iterations);
+  for (int i = 1; i < options.repetitions; i++)
+    result.nsPerIteration.push_back(RunOnce(benchmark, range, result.iterations, result) / result.iterations);
+
+  std::sort(result.nsPerIteration.begin(), result.nsPerIteration.end());
+
+  return result;
+}
+
+double GetMedian(const std::vector<double>& sortedValues)
+{
+  const size_t middle = sortedValues.size() / 2;
+  if (sortedValues.size() % 2 == 0)
+    return (sortedValues[middle - 1] + sortedValues[middle]) / 2;
+
+  return sortedValues[middle];
+}
+
+std::string ToJson(const std::vector<Result>& results, const RunnerOptions& options)
+{
+  std::ostringstream json;
+  json.precision(6);
+  json << std::fixed;
+
+  char date[32];
+  const time_t now = std::time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  json << "{\n  \"context\": {\n";
+  json << "    \"date\": \"" << date << "\",\n";
+  json << "    \"version\": \"" << STR(IPTV_VERSION) << "\",\n";
+#ifdef NDEBUG
+  json << "    \"build_type\": \"release\",\n";
+#else
+  json << "    \"build_type\": \"debug\",\n";
+#endif
+  json << "    \"min_time_ms\": " << options.minTimeMs << ",\n";
+  json << "    \"repetitions\": " << options.repetitions << "\n";
+  json << "  },\n  \"benchmarks\": [";
+
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result& result = results[i];
+    const double median = GetMedian(result.nsPerIteration);
+
+    json << (i == 0 ? "\n" : ",\n");
+    json << "    {\"name\": \"" << result.benchmarkName << "/" << result.range << "\", ";
+    json << "\"benchmark\": \"" << result.benchmarkName << "\", ";
+    json << "\"range\": " << result.range << ", ";
+    json << "\"iterations\": " << result.iterations << ", ";
+    json << "\"items_per_iteration\": " << result.itemsPerIteration << ", ";
+    json << "\"ns_per_iteration_median\": " << median << ", ";
+    json << "\"ns_per_iteration_min\": " << result.nsPerIteration.front() << ", ";
+    json << "\"ns_per_iteration_max\": " << result.nsPerIteration.back() << ", ";
+    json << "\"ns_per_item\": " << median / result.itemsPerIteration << ", ";
+    json << "\"allocations_per_item\": " << result.allocationsPerItem << "}";
+  }
+
+  json << "\n  ]\n}\n";
+
+  return json.str();
+}
+
+} // unnamed namespace
+
+std::vector<Benchmark>& benchmarks::GetBenchmarks()
+{
+  static std::vector<Benchmark> benchmarks;
+  return benchmarks;
+}
+
+int main(int argc, char* argv[])
+{
+  RunnerOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return EXIT_FAILURE;
+
+  std::vector<Benchmark> benchmarks = GetBenchmarks();
+  std::sort(benchmarks.begin(), benchmarks.end(), [](const Benchmark& a, const Benchmark& b) { return a.name < b.name; });
+
+  if (options.list)
+  {
+    for (const auto& benchmark : benchmarks)
+    {
+      printf("%s", benchmark.name.c_str());
+      for (int64_t range : benchmark.ranges)
+        printf(" %lld", static_cast<long long>(range));
+      printf("\n");
+    }
+    return EXIT_SUCCESS;
+  }
+
+  // The code under test logs and reads files through the helpers, the addon's log is kept quiet
+  harness::FakeKodi::GetInstance().SetLogLevel(ADDON::LOG_ERROR);
+  XBMC = new ADDON::CHelper_libXBMC_addon;
+  PVR = new CHelper_libXBMC_pvr;
+
+  std::vector<Result> results;
+  int failures = 0;
+  for (const auto& benchmark : benchmarks)
+  {
+    if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+      continue;
+
+    for (int64_t range : benchmark.ranges)
+    {
+      results.emplace_back(Run(benchmark, range, options));
+
+      const Result& result = results.back();
+      const double median = GetMedian(result.nsPerIteration);
+      fprintf(stderr, "%-40s %14.1f ns %14.1f ns/item %10.2f allocs/item %12zu iterations\n",
+              (result.benchmarkName + "/" + std::to_string(range)).c_str(), median,
+              median / result.itemsPerIteration, result.allocationsPerItem, result.iterations);
+
+      if (result.maxAllocationsPerItem >= 0 && result.allocationsPerItem > result.maxAllocationsPerItem)
+      {
+        fprintf(stderr, "FAILED: %s/%lld made %.2f allocations per item, no more than %.2f are expected\n",
+                result.benchmarkName.c_str(), static_cast<long long>(range), result.allocationsPerItem,
+                result.maxAllocationsPerItem);
+        failures++;
+      }
+    }
+  }
+
+  const std::string json = ToJson(results, options);
+  if (options.outputFile.empty())
+  {
+    std::cout << json;
+  }
+  else
+  {
+    std::ofstream file(options.outputFile);
+    file << json;
+    if (!file)
+    {
+      fprintf(stderr, "Unable to write '%s'\n", options.outputFile.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
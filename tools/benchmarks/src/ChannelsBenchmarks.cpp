@@ -0,0 +1,92 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Benchmark.h"
+#include "BenchmarkAccess.h"
+#include "BenchmarkData.h"
+
+#include "iptvsimple/ChannelGroups.h"
+
+#include <random>
+
+using namespace benchmarks;
+using namespace iptvsimple;
+
+namespace
+{
+
+const int LOOKUPS_PER_ITERATION = 1000;
+
+void BenchmarkGenerateChannelId(State& state)
+{
+  Channels channels;
+  ChannelGroups channelGroups(channels);
+  AddChannels(channels, channelGroups, static_cast<int>(state.GetRange()));
+
+  // Ids for channels in a playlist of the given size, the same names give the same ids so these probe
+  std::vector<std::pair<std::string, std::string>> channelsToAdd;
+  for (int i = 0; i < LOOKUPS_PER_ITERATION; i++)
+    channelsToAdd.emplace_back(GetChannelName(i), GetStreamUrl(i));
+
+  while (state.KeepRunning())
+  {
+    for (const auto& channelToAdd : channelsToAdd)
+      DoNotOptimize(BenchmarkAccess::GenerateChannelId(channels, channelToAdd.first, channelToAdd.second));
+  }
+
+  state.SetItemsPerIteration(LOOKUPS_PER_ITERATION);
+}
+
+void BenchmarkFindChannel(State& state)
+{
+  const int channelsAmount = static_cast<int>(state.GetRange());
+
+  Channels channels;
+  ChannelGroups channelGroups(channels);
+  AddChannels(channels, channelGroups, channelsAmount);
+
+  // Half the lookups are by id and half by display name only, as XMLTV files without matching ids do
+  std::mt19937 randomGenerator(1);
+  std::uniform_int_distribution<int> channelIndexes(0, channelsAmount - 1);
+  std::vector<std::pair<std::string, std::string>> lookups;
+  for (int i = 0; i < LOOKUPS_PER_ITERATION; i++)
+  {
+    const int channelIndex = channelIndexes(randomGenerator);
+    if (i % 2 == 0)
+      lookups.emplace_back(GetTvgId(channelIndex), GetChannelName(channelIndex));
+    else
+      lookups.emplace_back("", GetChannelName(channelIndex));
+  }
+
+  while (state.KeepRunning())
+  {
+    for (const auto& lookup : lookups)
+      DoNotOptimize(channels.FindChannel(lookup.first, lookup.second));
+  }
+
+  state.SetItemsPerIteration(LOOKUPS_PER_ITERATION);
+}
+
+Registration generateChannelId("Channels::GenerateChannelId", {1000, 10000, 100000}, BenchmarkGenerateChannelId);
+Registration findChannel("Channels::FindChannel", {100, 1000, 10000, 100000}, BenchmarkFindChannel);
+
+} // unnamed namespace
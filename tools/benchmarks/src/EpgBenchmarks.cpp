@@ -0,0 +1,175 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Benchmark.h"
+#include "BenchmarkAccess.h"
+#include "BenchmarkData.h"
+
+#include "iptvsimple/ChannelGroups.h"
+#include "iptvsimple/data/EpgEntry.h"
+#include "iptvsimple/data/EpgGenre.h"
+#include "iptvsimple/utilities/CancellationToken.h"
+
+#include "rapidxml/rapidxml.hpp"
+
+#include <climits>
+#include <ctime>
+#include <random>
+
+using namespace benchmarks;
+using namespace iptvsimple;
+using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
+using namespace rapidxml;
+
+namespace
+{
+
+const time_t XMLTV_START_TIME = 1577836800; // 2020-01-01 00:00:00 UTC
+
+/**
+ * Channels with their EPG channels loaded from an XMLTV of the given size
+ */
+class EpgFixture
+{
+public:
+  EpgFixture(int channelsAmount, int programmesPerChannel)
+    : m_channelGroups(m_channels), m_epg(m_channels, m_cancellationToken)
+  {
+    AddChannels(m_channels, m_channelGroups, channelsAmount);
+
+    m_xmltv = CreateXmltv(channelsAmount, programmesPerChannel, XMLTV_START_TIME);
+    m_document.parse<0>(&m_xmltv[0]);
+    m_rootElement = m_document.first_node("tv");
+
+    BenchmarkAccess::LoadChannelEpgs(m_epg, m_rootElement);
+  }
+
+  Channels& GetChannels() { return m_channels; }
+  Epg& GetEpg() { return m_epg; }
+  xml_node<>* GetRootElement() { return m_rootElement; }
+
+private:
+  Channels m_channels;
+  ChannelGroups m_channelGroups;
+  CancellationToken m_cancellationToken;
+  Epg m_epg;
+  std::string m_xmltv;
+  xml_document<> m_document;
+  xml_node<>* m_rootElement = nullptr;
+};
+
+void BenchmarkParseDateTime(State& state)
+{
+  // Parsing the start and stop times is all IsInWindow does besides comparing them
+  EpgFixture fixture(1, static_cast<int>(state.GetRange()));
+
+  std::vector<xml_node<>*> programmeNodes;
+  for (xml_node<>* node = fixture.GetRootElement()->first_node("programme"); node; node = node->next_sibling("programme"))
+    programmeNodes.emplace_back(node);
+
+  while (state.KeepRunning())
+  {
+    for (xml_node<>* programmeNode : programmeNodes)
+      DoNotOptimize(EpgEntry::IsInWindow(programmeNode, 0, INT_MAX, 0, 0));
+  }
+
+  state.SetItemsPerIteration(programmeNodes.size() * 2);
+}
+
+template<typename Lookup>
+void BenchmarkFindEpgForChannel(State& state, int lookupsPerIteration, const Lookup& lookup)
+{
+  const int channelsAmount = static_cast<int>(state.GetRange());
+  EpgFixture fixture(channelsAmount, 0);
+
+  std::mt19937 randomGenerator(1);
+  std::uniform_int_distribution<int> channelIndexes(0, channelsAmount - 1);
+  std::vector<int> lookupIndexes;
+  for (int i = 0; i < lookupsPerIteration; i++)
+    lookupIndexes.emplace_back(channelIndexes(randomGenerator));
+
+  while (state.KeepRunning())
+  {
+    for (int channelIndex : lookupIndexes)
+      DoNotOptimize(lookup(fixture, channelIndex));
+  }
+
+  state.SetItemsPerIteration(lookupsPerIteration);
+}
+
+void BenchmarkFindEpgForChannelById(State& state)
+{
+  std::vector<std::string> ids;
+  for (int i = 0; i < state.GetRange(); i++)
+    ids.emplace_back(GetTvgId(i));
+
+  BenchmarkFindEpgForChannel(state, 1000, [&ids](EpgFixture& fixture, int channelIndex)
+  {
+    return BenchmarkAccess::FindEpgForChannel(fixture.GetEpg(), ids[channelIndex]);
+  });
+}
+
+void BenchmarkFindEpgForChannelByChannel(State& state)
+{
+  // This is how GetEPGForChannel and the EPG logos find the channel's EPG
+  BenchmarkFindEpgForChannel(state, 100, [](EpgFixture& fixture, int channelIndex)
+  {
+    return BenchmarkAccess::FindEpgForChannel(fixture.GetEpg(), fixture.GetChannels().GetChannelsList()[channelIndex]);
+  });
+}
+
+void BenchmarkEpgEntryUpdateTo(State& state)
+{
+  EpgEntry epgEntry;
+  epgEntry.SetBroadcastId(1);
+  epgEntry.SetStartTime(XMLTV_START_TIME);
+  epgEntry.SetEndTime(XMLTV_START_TIME + 3600);
+  epgEntry.SetTitle("Programme title");
+  epgEntry.SetEpisodeName("Episode name");
+  epgEntry.SetPlot("The description of the programme, usually a sentence or two long.");
+  epgEntry.SetIconPath("http://logos.example/programme.png");
+  epgEntry.SetGenreString("Documentary");
+
+  // The genre is matched against the last genre in the list so all of them are compared
+  std::vector<EpgGenre> genres(state.GetRange());
+  for (size_t i = 0; i < genres.size(); i++)
+  {
+    genres[i].SetGenreType(static_cast<int>(i / 16) * 16);
+    genres[i].SetGenreSubType(static_cast<int>(i % 16));
+    genres[i].SetGenreString(i + 1 == genres.size() ? "Documentary" : "Genre " + std::to_string(i));
+  }
+
+  while (state.KeepRunning())
+  {
+    EPG_TAG tag = {0};
+    epgEntry.UpdateTo(tag, 1, 0, genres);
+    DoNotOptimize(tag);
+  }
+}
+
+Registration parseDateTime("EpgEntry::ParseDateTime", {100, 10000}, BenchmarkParseDateTime);
+Registration findEpgForChannelById("Epg::FindEpgForChannel(id)", {100, 1000, 10000}, BenchmarkFindEpgForChannelById);
+Registration findEpgForChannelByChannel("Epg::FindEpgForChannel(channel)", {10, 100, 1000}, BenchmarkFindEpgForChannelByChannel);
+Registration epgEntryUpdateTo("EpgEntry::UpdateTo", {0, 16, 256}, BenchmarkEpgEntryUpdateTo);
+
+} // unnamed namespace
@@ -0,0 +1,78 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+
+#include "iptvsimple/utilities/FileUtils.h"
+
+#include <zlib.h>
+
+using namespace benchmarks;
+using namespace iptvsimple::utilities;
+
+namespace
+{
+
+// Compressed the way XMLTV files are served, gzip framing at the default level
+std::string GzipDeflate(const std::string& uncompressedBytes)
+{
+  z_stream stream = {};
+  deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+
+  std::string compressedBytes(deflateBound(&stream, uncompressedBytes.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(uncompressedBytes.data()));
+  stream.avail_in = static_cast<uInt>(uncompressedBytes.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&compressedBytes[0]);
+  stream.avail_out = static_cast<uInt>(compressedBytes.size());
+
+  deflate(&stream, Z_FINISH);
+  compressedBytes.resize(stream.total_out);
+  deflateEnd(&stream);
+
+  return compressedBytes;
+}
+
+void BenchmarkGzipInflate(State& state)
+{
+  // The range is the uncompressed size in KB, made of XMLTV so it compresses like the real thing
+  const size_t targetSize = static_cast<size_t>(state.GetRange()) * 1024;
+  std::string xmltv;
+  for (int channels = 1; xmltv.size() < targetSize; channels *= 2)
+    xmltv = CreateXmltv(channels, 24, 1577836800);
+  xmltv.resize(targetSize);
+
+  const std::string compressedBytes = GzipDeflate(xmltv);
+
+  while (state.KeepRunning())
+  {
+    std::string uncompressedBytes;
+    DoNotOptimize(FileUtils::GzipInflate(compressedBytes, uncompressedBytes));
+    DoNotOptimize(uncompressedBytes);
+  }
+
+  state.SetItemsPerIteration(targetSize);
+}
+
+Registration gzipInflate("FileUtils::GzipInflate", {64, 1024, 16384}, BenchmarkGzipInflate);
+
+} // unnamed namespace
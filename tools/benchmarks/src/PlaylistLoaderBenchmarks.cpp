@@ -0,0 +1,128 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "Benchmark.h"
+#include "BenchmarkAccess.h"
+
+#include "CorpusGenerator.h"
+#include "iptvsimple/ChannelGroups.h"
+#include "iptvsimple/utilities/CancellationToken.h"
+
+#include "p8-platform/threads/mutex.h"
+
+#include <algorithm>
+
+using namespace benchmarks;
+using namespace generator;
+using namespace iptvsimple;
+using namespace iptvsimple::data;
+using namespace iptvsimple::utilities;
+
+namespace
+{
+
+// Parsing a generated playlist allocates 24 to 28 times per channel, for its strings, properties,
+// index entries and the logging of its lines. Each extra copy of a channel adds about 6 more.
+const double MAX_ALLOCATIONS_PER_CHANNEL = 30;
+
+// An #EXTINF line with the given number of extra attributes ahead of the usual ones, as some
+// providers add many, so the markers read last have to be searched for past all of them
+std::string CreateInfoLine(int extraAttributes)
+{
+  std::string line = "#EXTINF:-1";
+  for (int i = 0; i < extraAttributes; i++)
+    line += " x-attribute-" + std::to_string(i) + "=\"value " + std::to_string(i) + "\"";
+
+  line += " tvg-id=\"channel.1.example\" tvg-name=\"Channel_1\" tvg-logo=\"http://logos.example/channel1.png\""
+          " tvg-chno=\"101\" tvg-shift=\"1.5\" group-title=\"News;Entertainment\",Channel 1";
+
+  return line;
+}
+
+void BenchmarkReadMarkerValue(State& state)
+{
+  const std::string line = CreateInfoLine(static_cast<int>(state.GetRange()));
+
+  while (state.KeepRunning())
+  {
+    DoNotOptimize(BenchmarkAccess::ReadMarkerValue(line, TVG_INFO_ID_MARKER));
+    DoNotOptimize(BenchmarkAccess::ReadMarkerValue(line, GROUP_NAME_MARKER));
+    DoNotOptimize(BenchmarkAccess::ReadMarkerValue(line, RADIO_MARKER));
+  }
+
+  state.SetItemsPerIteration(3);
+}
+
+void BenchmarkParseIntoChannel(State& state)
+{
+  const std::string line = CreateInfoLine(static_cast<int>(state.GetRange()));
+
+  Channels channels;
+  ChannelGroups channelGroups(channels);
+  P8PLATFORM::CMutex mutex;
+  CancellationToken cancellationToken;
+  PlaylistLoader playlistLoader(channels, channelGroups, mutex, cancellationToken);
+
+  Channel channel;
+  std::vector<int> groupIdList;
+
+  while (state.KeepRunning())
+  {
+    channel.Reset();
+    DoNotOptimize(BenchmarkAccess::ParseIntoChannel(playlistLoader, line, channel, groupIdList, 0));
+  }
+}
+
+void BenchmarkParsePlaylist(State& state)
+{
+  PlaylistOptions playlistOptions;
+  playlistOptions.channels = static_cast<int>(state.GetRange());
+  playlistOptions.groups = std::max(1, playlistOptions.channels / 20);
+
+  std::string playlist;
+  CorpusGenerator(1, playlistOptions).GeneratePlaylist([&playlist](const std::string& text) { playlist += text; });
+
+  Channels loaderChannels;
+  ChannelGroups loaderChannelGroups(loaderChannels);
+  P8PLATFORM::CMutex mutex;
+  CancellationToken cancellationToken;
+  PlaylistLoader playlistLoader(loaderChannels, loaderChannelGroups, mutex, cancellationToken);
+
+  while (state.KeepRunning())
+  {
+    Channels channels;
+    ChannelGroups channelGroups(channels);
+    BenchmarkAccess::ParsePlaylist(playlistLoader, playlist, channels, channelGroups);
+    DoNotOptimize(channels.GetChannelsAmount());
+  }
+
+  state.SetItemsPerIteration(playlistOptions.channels);
+
+  // Channels are moved through the load path, copying them again would go over the limit
+  state.SetMaxAllocationsPerItem(MAX_ALLOCATIONS_PER_CHANNEL);
+}
+
+Registration readMarkerValue("PlaylistLoader::ReadMarkerValue", {0, 8, 64}, BenchmarkReadMarkerValue);
+Registration parseIntoChannel("PlaylistLoader::ParseIntoChannel", {0, 8, 64}, BenchmarkParseIntoChannel);
+Registration parsePlaylist("PlaylistLoader::ParsePlaylist", {100, 1000, 10000}, BenchmarkParsePlaylist);
+
+} // unnamed namespace
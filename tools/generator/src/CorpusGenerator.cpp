@@ -0,0 +1,484 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <queue>
+#include <vector>
+
+using namespace generator;
+
+namespace
+{
+
+// Separate random sequences are drawn for each purpose, so adding a feature to one does not change the others
+enum class RandomStream : uint64_t
+{
+  CHANNEL_IDENTITY = 1,
+  PLAYLIST_ENTRY = 2,
+  PROGRAMMES = 3,
+  UNMAPPED_PROGRAMMES = 4
+};
+
+const size_t OUTPUT_CHUNK_SIZE = 65536;
+const int SECONDS_IN_DAY = 24 * 60 * 60;
+
+const char* const CHANNEL_BRANDS[] = {"Atlas", "Beacon", "Cobalt", "Delta", "Ember", "Falcon", "Granite", "Harbour",
+                                      "Iris", "Juniper", "Kestrel", "Lumen", "Meridian", "Nova", "Orbit", "Pioneer"};
+const char* const CHANNEL_TOPICS[] = {"News", "Sport", "Movies", "Kids", "Music", "Documentary", "Comedy", "Drama",
+                                      "Travel", "Food", "Science", "History", "Nature", "Business", "Gaming", "Fashion"};
+const char* const CHANNEL_REGIONS[] = {"uk", "us", "de", "fr", "es", "it", "nl", "pl", "se", "pt"};
+const char* const TVG_SHIFTS[] = {"-2", "-1", "0.5", "1", "2", "5.5"};
+const char* const USER_AGENTS[] = {"Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36",
+                                   "VLC/3.0.11 LibVLC/3.0.11", "Kodi/18.9 (Linux; Android 9)"};
+const char* const CATEGORIES[] = {"Movie", "News &amp; Weather", "Sports", "Children's", "Music", "Documentary",
+                                  "Comedy", "Drama", "Entertainment", "Lifestyle", "Reality", "Talk Show"};
+const char* const WORDS[] = {"the", "a", "of", "and", "in", "journey", "city", "night", "river", "mystery", "family",
+                             "secret", "island", "summer", "winter", "kitchen", "garden", "race", "final", "live",
+                             "world", "north", "south", "stories", "season", "match", "road", "house", "history",
+                             "wild", "ocean", "mountain", "legend", "return", "friends", "between", "under", "golden"};
+const char* const PEOPLE[] = {"Alex Morgan", "Sam Taylor", "Jordan Lee", "Casey Brown", "Robin Clarke", "Jamie Patel",
+                              "Morgan Ruiz", "Taylor Kim", "Charlie Evans", "Drew Novak", "Riley Costa", "Avery Lund"};
+const int PROGRAMME_MINUTES[] = {15, 30, 30, 45, 60, 60, 60, 90, 120};
+const int UTC_OFFSETS_SECS[] = {0, 0, 0, 0, 3600, 7200, -18000, 19800};
+
+/**
+ * splitmix64, small and fully specified so the sequence is the same everywhere
+ */
+class Random
+{
+public:
+  Random(uint32_t seed, RandomStream stream, uint64_t index)
+    : m_state((static_cast<uint64_t>(seed) << 32) ^ (static_cast<uint64_t>(stream) << 56) ^ index)
+  {
+    // Mix the parts of the seed so neighbouring channels start far apart
+    NextUint64();
+    m_state ^= index * 0x9E3779B97F4A7C15ULL;
+  }
+
+  uint32_t Next(uint32_t bound) { return static_cast<uint32_t>(NextUint64() % bound); }
+  bool Chance(double ratio) { return (NextUint64() >> 11) * (1.0 / 9007199254740992.0) < ratio; }
+
+  template<size_t N>
+  const char* Pick(const char* const (&values)[N]) { return values[Next(N)]; }
+  template<size_t N>
+  int Pick(const int (&values)[N]) { return values[Next(N)]; }
+
+private:
+  uint64_t NextUint64()
+  {
+    uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t m_state;
+};
+
+/**
+ * Buffers the output so the handler is called with large chunks
+ */
+class OutputBuffer
+{
+public:
+  OutputBuffer(const OutputHandler& outputHandler) : m_outputHandler(outputHandler) {}
+  ~OutputBuffer() { Flush(); }
+
+  std::string& Get() { return m_buffer; }
+
+  void FlushIfFull()
+  {
+    if (m_buffer.size() >= OUTPUT_CHUNK_SIZE)
+      Flush();
+  }
+
+  void Flush()
+  {
+    if (!m_buffer.empty())
+      m_outputHandler(m_buffer);
+    m_buffer.clear();
+  }
+
+private:
+  const OutputHandler& m_outputHandler;
+  std::string m_buffer;
+};
+
+// Days since the epoch to a civil date, from Howard Hinnant's date algorithms
+void CivilFromDays(int64_t days, int& year, int& month, int& day)
+{
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int64_t dayOfEra = days - era * 146097;
+  const int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+  day = static_cast<int>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+  month = static_cast<int>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+  year = static_cast<int>(yearOfEra + era * 400 + (month <= 2 ? 1 : 0));
+}
+
+void AppendXmltvTime(std::string& output, time_t utcTime, int utcOffsetSecs)
+{
+  const int64_t localTime = static_cast<int64_t>(utcTime) + utcOffsetSecs;
+  int64_t days = localTime / SECONDS_IN_DAY;
+  int64_t secondsOfDay = localTime % SECONDS_IN_DAY;
+  if (secondsOfDay < 0)
+  {
+    secondsOfDay += SECONDS_IN_DAY;
+    days--;
+  }
+
+  int year;
+  int month;
+  int day;
+  CivilFromDays(days, year, month, day);
+
+  const int offsetMinutes = std::abs(utcOffsetSecs) / 60;
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%04d%02d%02d%02d%02d%02d %c%02d%02d", year, month, day,
+           static_cast<int>(secondsOfDay / 3600), static_cast<int>(secondsOfDay / 60 % 60), static_cast<int>(secondsOfDay % 60),
+           utcOffsetSecs < 0 ? '-' : '+', offsetMinutes / 60, offsetMinutes % 60);
+  output += buffer;
+}
+
+void AppendWords(std::string& output, Random& random, int minWords, int maxWords, bool capitalise)
+{
+  const int words = minWords + static_cast<int>(random.Next(maxWords - minWords + 1));
+  for (int i = 0; i < words; i++)
+  {
+    if (i > 0)
+      output += ' ';
+
+    const size_t wordStart = output.size();
+    output += random.Pick(WORDS);
+    if (capitalise || i == 0)
+      output[wordStart] = static_cast<char>(toupper(output[wordStart]));
+  }
+}
+
+/**
+ * The programmes of one XMLTV channel, generated one at a time so channels can be interleaved
+ */
+class ProgrammeSequence
+{
+public:
+  ProgrammeSequence(const std::string& id, Random random, time_t startTime, time_t endTime)
+    : m_id(id), m_random(random), m_nextStartTime(startTime), m_endTime(endTime)
+  {
+    m_utcOffsetSecs = m_random.Pick(UTC_OFFSETS_SECS);
+  }
+
+  bool HasNext() const { return m_nextStartTime < m_endTime; }
+  time_t GetNextStartTime() const { return m_nextStartTime; }
+
+  void AppendNext(std::string& output)
+  {
+    const time_t startTime = m_nextStartTime;
+    m_nextStartTime += m_random.Pick(PROGRAMME_MINUTES) * 60;
+
+    output += "  <programme start=\"";
+    AppendXmltvTime(output, startTime, m_utcOffsetSecs);
+    output += "\" stop=\"";
+    AppendXmltvTime(output, m_nextStartTime, m_utcOffsetSecs);
+    output += "\" channel=\"" + m_id + "\">\n";
+
+    output += "    <title lang=\"en\">";
+    AppendWords(output, m_random, 1, 4, true);
+    output += "</title>\n";
+
+    if (m_random.Chance(0.5))
+    {
+      output += "    <sub-title lang=\"en\">";
+      AppendWords(output, m_random, 2, 6, false);
+      output += "</sub-title>\n";
+    }
+
+    output += "    <desc lang=\"en\">";
+    AppendWords(output, m_random, 10, 50, false);
+    output += ".</desc>\n";
+
+    if (m_random.Chance(0.2))
+    {
+      output += "    <credits>\n";
+      output += std::string("      <director>") + m_random.Pick(PEOPLE) + "</director>\n";
+      output += std::string("      <actor>") + m_random.Pick(PEOPLE) + "</actor>\n";
+      output += std::string("      <actor>") + m_random.Pick(PEOPLE) + "</actor>\n";
+      output += "    </credits>\n";
+    }
+
+    output += std::string("    <category lang=\"en\">") + m_random.Pick(CATEGORIES) + "</category>\n";
+
+    if (m_random.Chance(0.3))
+      output += "    <episode-num system=\"xmltv_ns\">" + std::to_string(m_random.Next(10)) + "." +
+                std::to_string(m_random.Next(24)) + ".</episode-num>\n";
+
+    if (m_random.Chance(0.3))
+      output += "    <icon src=\"http://images.example/programmes/" + std::to_string(m_random.Next(100000)) + ".jpg\" />\n";
+
+    output += "  </programme>\n";
+  }
+
+private:
+  std::string m_id;
+  Random m_random;
+  time_t m_nextStartTime;
+  time_t m_endTime;
+  int m_utcOffsetSecs;
+};
+
+void AppendOctal(char* field, size_t fieldSize, uint64_t value)
+{
+  snprintf(field, fieldSize, "%0*llo", static_cast<int>(fieldSize - 1), static_cast<unsigned long long>(value));
+}
+
+} // unnamed namespace
+
+CorpusGenerator::CorpusGenerator(uint32_t seed, const PlaylistOptions& playlistOptions)
+  : m_seed(seed), m_playlistOptions(playlistOptions) {}
+
+CorpusGenerator::ChannelIdentity CorpusGenerator::GetChannelIdentity(int channelIndex) const
+{
+  Random random(m_seed, RandomStream::CHANNEL_IDENTITY, channelIndex);
+
+  ChannelIdentity identity;
+  identity.nameOnly = random.Chance(m_playlistOptions.nameOnlyRatio);
+  identity.radio = random.Chance(m_playlistOptions.radioRatio);
+
+  const std::string brand = random.Pick(CHANNEL_BRANDS);
+  const std::string topic = identity.radio ? "Radio" : random.Pick(CHANNEL_TOPICS);
+  const std::string region = random.Pick(CHANNEL_REGIONS);
+  const bool hd = !identity.radio && random.Chance(0.3);
+
+  // The index keeps the names unique however many channels there are
+  identity.name = brand + " " + topic + " " + std::to_string(channelIndex + 1) + (hd ? " HD" : "");
+
+  identity.tvgId = brand + topic + std::to_string(channelIndex + 1) + (hd ? "HD" : "") + "." + region;
+  std::transform(identity.tvgId.begin(), identity.tvgId.end(), identity.tvgId.begin(), ::tolower);
+
+  return identity;
+}
+
+void CorpusGenerator::GeneratePlaylist(const OutputHandler& outputHandler) const
+{
+  const int radioGroups = m_playlistOptions.radioRatio > 0 ? std::max(1, static_cast<int>(std::lround(m_playlistOptions.groups * m_playlistOptions.radioRatio))) : 0;
+  const int tvGroups = std::max(1, m_playlistOptions.groups - radioGroups);
+
+  auto getGroupName = [tvGroups, radioGroups](Random& random, bool radio)
+  {
+    if (radio)
+      return "Radio " + std::to_string(random.Next(radioGroups) + 1);
+
+    const uint32_t groupIndex = random.Next(tvGroups);
+    const size_t topics = sizeof(CHANNEL_TOPICS) / sizeof(CHANNEL_TOPICS[0]);
+    return std::string(CHANNEL_TOPICS[groupIndex % topics]) + " " + std::to_string(groupIndex / topics + 1);
+  };
+
+  OutputBuffer output(outputHandler);
+  output.Get() += "#EXTM3U\n";
+
+  for (int i = 0; i < m_playlistOptions.channels; i++)
+  {
+    const ChannelIdentity identity = GetChannelIdentity(i);
+    Random random(m_seed, RandomStream::PLAYLIST_ENTRY, i);
+
+    std::string tvgName = identity.name;
+    std::replace(tvgName.begin(), tvgName.end(), ' ', '_');
+
+    std::string groupNames = getGroupName(random, identity.radio);
+    if (random.Chance(m_playlistOptions.multipleGroupsRatio))
+    {
+      const std::string secondGroupName = getGroupName(random, identity.radio);
+      if (secondGroupName != groupNames)
+        groupNames += ";" + secondGroupName;
+    }
+
+    std::string& line = output.Get();
+    line += "#EXTINF:-1";
+    if (!identity.nameOnly)
+      line += " tvg-id=\"" + identity.tvgId + "\"";
+    line += " tvg-name=\"" + tvgName + "\"";
+    if (random.Chance(0.9))
+      line += " tvg-logo=\"http://logos.example/" + identity.tvgId + ".png\"";
+    if (random.Chance(0.5))
+      line += " tvg-chno=\"" + std::to_string(i + 1) + "\"";
+    if (random.Chance(m_playlistOptions.tvgShiftRatio))
+      line += std::string(" tvg-shift=\"") + random.Pick(TVG_SHIFTS) + "\"";
+    if (identity.radio)
+      line += " radio=\"true\"";
+    line += " group-title=\"" + groupNames + "\"," + identity.name + "\n";
+
+    if (random.Chance(m_playlistOptions.kodipropRatio))
+    {
+      line += "#KODIPROP:inputstreamaddon=inputstream.adaptive\n";
+      line += "#KODIPROP:inputstream.adaptive.manifest_type=" + std::string(random.Chance(0.5) ? "mpd" : "hls") + "\n";
+    }
+
+    if (random.Chance(m_playlistOptions.extvlcoptRatio))
+      line += std::string("#EXTVLCOPT:http-user-agent=") + random.Pick(USER_AGENTS) + "\n";
+
+    if (identity.radio)
+      line += "http://radio.example/stream/" + std::to_string(i + 1) + ".aac\n";
+    else if (random.Chance(0.3))
+      line += "https://cdn" + std::to_string(random.Next(8) + 1) + ".example/live/" + identity.tvgId + "/index.m3u8\n";
+    else
+      line += "http://streams.example:8080/live/user/pass/" + std::to_string(i + 1) + ".ts\n";
+
+    output.FlushIfFull();
+  }
+}
+
+void CorpusGenerator::GenerateXmltv(const XmltvOptions& xmltvOptions, const OutputHandler& outputHandler) const
+{
+  const int mappedChannels = std::min(xmltvOptions.channels, m_playlistOptions.channels);
+  const int unmappedChannels = static_cast<int>(std::lround(mappedChannels * xmltvOptions.unmappedRatio));
+  const time_t endTime = xmltvOptions.startTime + static_cast<time_t>(xmltvOptions.days) * SECONDS_IN_DAY;
+
+  // Unmapped channels are spread evenly between the mapped ones, as providers do not list them separately
+  struct XmltvChannel
+  {
+    std::string id;
+    std::string name;
+    bool unmapped;
+    int index;
+  };
+
+  std::vector<XmltvChannel> channels;
+  channels.reserve(mappedChannels + unmappedChannels);
+  int unmappedAdded = 0;
+  for (int i = 0; i < mappedChannels; i++)
+  {
+    const ChannelIdentity identity = GetChannelIdentity(i);
+    // Channels without a tvg-id still have one in the XMLTV, it just matches nothing in the playlist
+    channels.push_back({identity.nameOnly ? "epg." + identity.tvgId : identity.tvgId, identity.name, false, i});
+
+    while (static_cast<int64_t>(unmappedAdded) * mappedChannels < static_cast<int64_t>(i + 1) * unmappedChannels)
+    {
+      unmappedAdded++;
+      channels.push_back({"unmapped" + std::to_string(unmappedAdded) + ".example", "Unmapped " + std::to_string(unmappedAdded), true, unmappedAdded});
+    }
+  }
+
+  OutputBuffer output(outputHandler);
+  output.Get() += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+  output.Get() += "<!DOCTYPE tv SYSTEM \"xmltv.dtd\">\n";
+  output.Get() += "<tv generator-info-name=\"iptvsimple-generate\">\n";
+
+  for (const auto& channel : channels)
+  {
+    std::string& text = output.Get();
+    text += "  <channel id=\"" + channel.id + "\">\n";
+    text += "    <display-name>" + channel.name + "</display-name>\n";
+    if (!channel.unmapped)
+      text += "    <icon src=\"http://logos.example/epg/" + channel.id + ".png\" />\n";
+    text += "  </channel>\n";
+    output.FlushIfFull();
+  }
+
+  auto createProgrammeSequence = [&](const XmltvChannel& channel)
+  {
+    const RandomStream stream = channel.unmapped ? RandomStream::UNMAPPED_PROGRAMMES : RandomStream::PROGRAMMES;
+    return ProgrammeSequence(channel.id, Random(m_seed, stream, channel.index), xmltvOptions.startTime, endTime);
+  };
+
+  if (xmltvOptions.order == ProgrammeOrder::GROUPED)
+  {
+    for (const auto& channel : channels)
+    {
+      ProgrammeSequence programmes = createProgrammeSequence(channel);
+      while (programmes.HasNext())
+      {
+        programmes.AppendNext(output.Get());
+        output.FlushIfFull();
+      }
+    }
+  }
+  else
+  {
+    std::vector<ProgrammeSequence> programmeSequences;
+    programmeSequences.reserve(channels.size());
+    for (const auto& channel : channels)
+      programmeSequences.emplace_back(createProgrammeSequence(channel));
+
+    // Earliest start time first, ties in channel order
+    typedef std::pair<time_t, size_t> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    for (size_t i = 0; i < programmeSequences.size(); i++)
+    {
+      if (programmeSequences[i].HasNext())
+        queue.push({programmeSequences[i].GetNextStartTime(), i});
+    }
+
+    while (!queue.empty())
+    {
+      const size_t sequenceIndex = queue.top().second;
+      queue.pop();
+
+      ProgrammeSequence& programmes = programmeSequences[sequenceIndex];
+      programmes.AppendNext(output.Get());
+      output.FlushIfFull();
+
+      if (programmes.HasNext())
+        queue.push({programmes.GetNextStartTime(), sequenceIndex});
+    }
+  }
+
+  output.Get() += "</tv>\n";
+}
+
+std::string CorpusGenerator::CreateTarArchive(const std::string& fileName, const std::string& contents)
+{
+  // A ustar header followed by the contents padded to the record size and two empty records
+  static const size_t RECORD_SIZE = 512;
+
+  std::string archive(RECORD_SIZE, '\0');
+  char* header = &archive[0];
+
+  strncpy(header, fileName.c_str(), 99);
+  AppendOctal(header + 100, 8, 0644);      // mode
+  AppendOctal(header + 108, 8, 0);         // uid
+  AppendOctal(header + 116, 8, 0);         // gid
+  AppendOctal(header + 124, 12, contents.size());
+  AppendOctal(header + 136, 12, 0);        // mtime, left at 0 so the output does not change
+  header[156] = '0';                       // regular file
+  memcpy(header + 257, "ustar", 6);
+  memcpy(header + 263, "00", 2);
+
+  // The checksum is calculated with its own field filled with spaces
+  memset(header + 148, ' ', 8);
+  unsigned int checksum = 0;
+  for (size_t i = 0; i < RECORD_SIZE; i++)
+    checksum += static_cast<unsigned char>(header[i]);
+  snprintf(header + 148, 8, "%06o", checksum);
+
+  archive += contents;
+  archive.append((RECORD_SIZE - contents.size() % RECORD_SIZE) % RECORD_SIZE, '\0');
+  archive.append(RECORD_SIZE * 2, '\0');
+
+  return archive;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+
+namespace generator
+{
+  /**
+   * Receives the generated text in order, so large files can be written out as they are generated
+   */
+  typedef std::function<void(const std::string& text)> OutputHandler;
+
+  struct PlaylistOptions
+  {
+    int channels = 1000;
+    int groups = 50;
+    // Fractions of the channels with each feature
+    double radioRatio = 0.05;
+    double kodipropRatio = 0.1;
+    double extvlcoptRatio = 0.05;
+    double tvgShiftRatio = 0.1;
+    double multipleGroupsRatio = 0.1;
+    // Channels without a tvg-id, their EPG can only be found by name
+    double nameOnlyRatio = 0.05;
+  };
+
+  enum class ProgrammeOrder
+  {
+    GROUPED,     // All programmes of a channel before the next channel's
+    INTERLEAVED  // Programmes of all channels in order of start time
+  };
+
+  struct XmltvOptions
+  {
+    // Channels mapped to the playlist, the first ones of the playlist are used
+    int channels = 1000;
+    // Extra channels as a fraction of the mapped ones, with ids that are not in the playlist
+    double unmappedRatio = 0.05;
+    int days = 7;
+    time_t startTime = 0;
+    ProgrammeOrder order = ProgrammeOrder::GROUPED;
+  };
+
+  /**
+   * Generates a playlist and an XMLTV that fit together. The same seed and options always give
+   * the same output on every platform: the random numbers come from a generator implemented
+   * here rather than the standard library distributions, whose results vary between
+   * implementations. Each channel has a random sequence of its own, so its programmes
+   * do not depend on the order they are written in.
+   */
+  class CorpusGenerator
+  {
+  public:
+    CorpusGenerator(uint32_t seed, const PlaylistOptions& playlistOptions);
+
+    void GeneratePlaylist(const OutputHandler& outputHandler) const;
+    void GenerateXmltv(const XmltvOptions& xmltvOptions, const OutputHandler& outputHandler) const;
+
+    /**
+     * Wraps a file in a single entry tar archive, as some providers serve their XMLTV
+     */
+    static std::string CreateTarArchive(const std::string& fileName, const std::string& contents);
+
+  private:
+    struct ChannelIdentity
+    {
+      std::string tvgId;
+      std::string name;
+      bool nameOnly;
+      bool radio;
+    };
+
+    ChannelIdentity GetChannelIdentity(int channelIndex) const;
+
+    uint32_t m_seed;
+    PlaylistOptions m_playlistOptions;
+  };
+} // namespace generator
@@ -0,0 +1,296 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Writes a playlist and an XMLTV of any size for the harness and benchmarks, as
+ * provider feeds cannot be shared. Run it with --help for the options.
+ */
+
+#include "CorpusGenerator.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+#include <zlib.h>
+
+using namespace generator;
+
+namespace
+{
+
+enum class XmltvPacking
+{
+  NONE,
+  GZIP,
+  TAR,
+  TAR_GZIP
+};
+
+struct GeneratorOptions
+{
+  uint32_t seed = 1;
+  std::string outputDirectory = ".";
+  bool writePlaylist = true;
+  bool writeXmltv = true;
+  int xmltvChannels = -1;
+  XmltvPacking packing = XmltvPacking::NONE;
+  PlaylistOptions playlistOptions;
+  XmltvOptions xmltvOptions;
+};
+
+/**
+ * A file written as is or gzip compressed
+ */
+class OutputFile
+{
+public:
+  ~OutputFile() { Close(); }
+
+  bool Open(const std::string& path, bool compress)
+  {
+    m_path = path;
+    if (compress)
+      m_gzFile = gzopen(path.c_str(), "wb");
+    else
+      m_file = fopen(path.c_str(), "wb");
+
+    if (!m_gzFile && !m_file)
+    {
+      fprintf(stderr, "Unable to open '%s' for writing\n", path.c_str());
+      return false;
+    }
+
+    return true;
+  }
+
+  void Write(const std::string& text)
+  {
+    if (m_gzFile)
+      m_failed |= gzwrite(m_gzFile, text.data(), static_cast<unsigned int>(text.size())) != static_cast<int>(text.size());
+    else
+      m_failed |= fwrite(text.data(), 1, text.size(), m_file) != text.size();
+    m_bytesWritten += text.size();
+  }
+
+  bool Close()
+  {
+    if (m_gzFile)
+      m_failed |= gzclose(m_gzFile) != Z_OK;
+    if (m_file)
+      m_failed |= fclose(m_file) != 0;
+    m_gzFile = nullptr;
+    m_file = nullptr;
+
+    if (m_failed)
+      fprintf(stderr, "Unable to write '%s'\n", m_path.c_str());
+
+    return !m_failed;
+  }
+
+  size_t GetBytesWritten() const { return m_bytesWritten; }
+
+private:
+  std::string m_path;
+  FILE* m_file = nullptr;
+  gzFile m_gzFile = nullptr;
+  size_t m_bytesWritten = 0;
+  bool m_failed = false;
+};
+
+void PrintUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --help                        Show this help\n"
+          "  --seed <number>               Seed, the same seed and options give the same files, default 1\n"
+          "  --out-dir <dir>               Directory the files are written to, default the current one\n"
+          "  --no-playlist                 Do not write playlist.m3u\n"
+          "  --no-xmltv                    Do not write the XMLTV\n"
+          "Playlist:\n"
+          "  --channels <count>            Channels, default 1000\n"
+          "  --groups <count>              Channel groups, default 50\n"
+          "  --radio-ratio <0-1>           Fraction of radio channels, default 0.05\n"
+          "  --kodiprop-ratio <0-1>        Fraction of channels with #KODIPROP lines, default 0.1\n"
+          "  --extvlcopt-ratio <0-1>       Fraction of channels with an #EXTVLCOPT line, default 0.05\n"
+          "  --tvg-shift-ratio <0-1>       Fraction of channels with a tvg-shift, default 0.1\n"
+          "  --multiple-groups-ratio <0-1> Fraction of channels in two groups, default 0.1\n"
+          "  --name-only-ratio <0-1>       Fraction of channels without a tvg-id, default 0.05\n"
+          "XMLTV:\n"
+          "  --xmltv-channels <count>      Channels with EPG, the first of the playlist, default all\n"
+          "  --unmapped-ratio <0-1>        Extra channels not in the playlist, per channel with EPG, default 0.05\n"
+          "  --days <count>                Days of programmes, default 7\n"
+          "  --start-time <unix time>      Start of the programmes, default the start of yesterday (UTC).\n"
+          "                                Give it to get the same files on another day\n"
+          "  --order grouped|interleaved   Programmes by channel or by start time, default grouped\n"
+          "  --packing none|gzip|tar|tar.gz  How the XMLTV is packed, default none\n",
+          program);
+}
+
+bool ParseOptions(int argc, char* argv[], GeneratorOptions& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string option = argv[i];
+    if (option == "--no-playlist")
+    {
+      options.writePlaylist = false;
+      continue;
+    }
+    else if (option == "--no-xmltv")
+    {
+      options.writeXmltv = false;
+      continue;
+    }
+    else if (option == "--help" || i + 1 >= argc)
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+
+    const std::string value = argv[++i];
+    const int intValue = std::atoi(value.c_str());
+    const double ratioValue = std::atof(value.c_str());
+
+    if (option == "--seed")
+      options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    else if (option == "--out-dir")
+      options.outputDirectory = value;
+    else if (option == "--channels")
+      options.playlistOptions.channels = intValue;
+    else if (option == "--groups")
+      options.playlistOptions.groups = intValue;
+    else if (option == "--radio-ratio")
+      options.playlistOptions.radioRatio = ratioValue;
+    else if (option == "--kodiprop-ratio")
+      options.playlistOptions.kodipropRatio = ratioValue;
+    else if (option == "--extvlcopt-ratio")
+      options.playlistOptions.extvlcoptRatio = ratioValue;
+    else if (option == "--tvg-shift-ratio")
+      options.playlistOptions.tvgShiftRatio = ratioValue;
+    else if (option == "--multiple-groups-ratio")
+      options.playlistOptions.multipleGroupsRatio = ratioValue;
+    else if (option == "--name-only-ratio")
+      options.playlistOptions.nameOnlyRatio = ratioValue;
+    else if (option == "--xmltv-channels")
+      options.xmltvChannels = intValue;
+    else if (option == "--unmapped-ratio")
+      options.xmltvOptions.unmappedRatio = ratioValue;
+    else if (option == "--days")
+      options.xmltvOptions.days = intValue;
+    else if (option == "--start-time")
+      options.xmltvOptions.startTime = static_cast<time_t>(std::atoll(value.c_str()));
+    else if (option == "--order" && (value == "grouped" || value == "interleaved"))
+      options.xmltvOptions.order = value == "grouped" ? ProgrammeOrder::GROUPED : ProgrammeOrder::INTERLEAVED;
+    else if (option == "--packing" && value == "none")
+      options.packing = XmltvPacking::NONE;
+    else if (option == "--packing" && value == "gzip")
+      options.packing = XmltvPacking::GZIP;
+    else if (option == "--packing" && value == "tar")
+      options.packing = XmltvPacking::TAR;
+    else if (option == "--packing" && value == "tar.gz")
+      options.packing = XmltvPacking::TAR_GZIP;
+    else
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+  }
+
+  if (options.playlistOptions.channels < 1 || options.playlistOptions.groups < 1 || options.xmltvOptions.days < 0)
+  {
+    fprintf(stderr, "There has to be at least one channel and one group\n");
+    return false;
+  }
+
+  options.xmltvOptions.channels = options.xmltvChannels < 0 ? options.playlistOptions.channels : options.xmltvChannels;
+
+  if (options.xmltvOptions.startTime == 0)
+    options.xmltvOptions.startTime = std::time(nullptr) / (24 * 60 * 60) * (24 * 60 * 60) - 24 * 60 * 60;
+
+  return true;
+}
+
+bool WritePlaylist(const CorpusGenerator& corpusGenerator, const GeneratorOptions& options)
+{
+  const std::string path = options.outputDirectory + "/playlist.m3u";
+  OutputFile file;
+  if (!file.Open(path, false))
+    return false;
+
+  corpusGenerator.GeneratePlaylist([&file](const std::string& text) { file.Write(text); });
+
+  if (!file.Close())
+    return false;
+
+  printf("%s: %zu bytes\n", path.c_str(), file.GetBytesWritten());
+  return true;
+}
+
+bool WriteXmltv(const CorpusGenerator& corpusGenerator, const GeneratorOptions& options)
+{
+  static const char* const fileNames[] = {"xmltv.xml", "xmltv.xml.gz", "xmltv.tar", "xmltv.tar.gz"};
+  const std::string path = options.outputDirectory + "/" + fileNames[static_cast<int>(options.packing)];
+  const bool compress = options.packing == XmltvPacking::GZIP || options.packing == XmltvPacking::TAR_GZIP;
+
+  OutputFile file;
+  if (!file.Open(path, compress))
+    return false;
+
+  if (options.packing == XmltvPacking::TAR || options.packing == XmltvPacking::TAR_GZIP)
+  {
+    // The size goes in the tar header so the XMLTV is generated in memory first
+    std::string xmltv;
+    corpusGenerator.GenerateXmltv(options.xmltvOptions, [&xmltv](const std::string& text) { xmltv += text; });
+    file.Write(CorpusGenerator::CreateTarArchive("xmltv.xml", xmltv));
+  }
+  else
+  {
+    corpusGenerator.GenerateXmltv(options.xmltvOptions, [&file](const std::string& text) { file.Write(text); });
+  }
+
+  if (!file.Close())
+    return false;
+
+  printf("%s: %zu bytes before compression\n", path.c_str(), file.GetBytesWritten());
+  return true;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+  GeneratorOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return EXIT_FAILURE;
+
+  const CorpusGenerator corpusGenerator(options.seed, options.playlistOptions);
+
+  if (options.writePlaylist && !WritePlaylist(corpusGenerator, options))
+    return EXIT_FAILURE;
+
+  if (options.writeXmltv && !WriteXmltv(corpusGenerator, options))
+    return EXIT_FAILURE;
+
+  return EXIT_SUCCESS;
+}
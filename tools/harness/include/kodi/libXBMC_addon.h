@@ -0,0 +1,77 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Stands in for Kodi's libXBMC_addon.h when building the headless harness. Only the calls the
+ * addon makes are provided, files and URLs are served from the local file system by FakeVfs.
+ */
+
+#include "kodi/xbmc_addon_types.h"
+#include "p8-platform/os.h"
+
+#include <cstddef>
+#include <string>
+
+#ifdef TARGET_WINDOWS
+#ifdef CreateDirectory
+#undef CreateDirectory
+#endif
+#ifdef DeleteFile
+#undef DeleteFile
+#endif
+#endif
+
+namespace ADDON
+{
+  typedef enum addon_log
+  {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_NOTICE,
+    LOG_WARNING,
+    LOG_ERROR
+  } addon_log_t;
+
+  class CHelper_libXBMC_addon
+  {
+  public:
+    bool RegisterMe(void* handle) { return true; }
+
+    void Log(const addon_log_t loglevel, const char* format, ...);
+    bool GetSetting(const std::string& settingName, void* settingValue);
+
+    char* UnknownToUTF8(const char* str);
+    void FreeString(char* str);
+
+    void* OpenFile(const char* strFileName, unsigned int flags);
+    void* OpenFileForWrite(const char* strFileName, bool bOverWrite);
+    ssize_t ReadFile(void* file, void* lpBuf, size_t uiBufSize);
+    ssize_t WriteFile(void* file, const void* lpBuf, size_t uiBufSize);
+    void CloseFile(void* file);
+    bool FileExists(const char* strFileName, bool bUseCache);
+    int StatFile(const char* strFileName, struct __stat64* buffer);
+    bool DeleteFile(const char* strFileName);
+    bool CreateDirectory(const char* strPath);
+    bool DirectoryExists(const char* strPath);
+  };
+} // namespace ADDON
@@ -0,0 +1,46 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Stands in for Kodi's libXBMC_pvr.h when building the headless harness. Transferred
+ * entries are handed to the TransferCollector the handle points at and triggers are counted.
+ */
+
+#include "kodi/xbmc_pvr_types.h"
+
+class CHelper_libXBMC_pvr
+{
+public:
+  bool RegisterMe(void* handle) { return true; }
+
+  void TransferEpgEntry(const ADDON_HANDLE handle, const EPG_TAG* entry);
+  void TransferChannelEntry(const ADDON_HANDLE handle, const PVR_CHANNEL* entry);
+  void TransferChannelGroup(const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP* entry);
+  void TransferChannelGroupMember(const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP_MEMBER* entry);
+
+  void AddMenuHook(PVR_MENUHOOK* hook);
+
+  void TriggerChannelUpdate();
+  void TriggerChannelGroupsUpdate();
+  void TriggerEpgUpdate(unsigned int iChannelUid);
+};
@@ -0,0 +1,182 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "FakeKodi.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace ADDON;
+using namespace harness;
+
+namespace
+{
+
+struct FakeFile
+{
+  FILE* file;
+  bool isRemote;
+  bool connected;
+};
+
+const char* LOG_LEVEL_NAMES[] = {"DEBUG", "INFO", "NOTICE", "WARNING", "ERROR"};
+
+// Throttled reads are kept small so the bandwidth is spread evenly over the transfer
+const size_t REMOTE_READ_CHUNK_SIZE = 16384;
+
+} // unnamed namespace
+
+void CHelper_libXBMC_addon::Log(const addon_log_t loglevel, const char* format, ...)
+{
+  if (loglevel < FakeKodi::GetInstance().GetLogLevel())
+    return;
+
+  va_list arguments;
+  va_start(arguments, format);
+  fprintf(stderr, "%-7s ", LOG_LEVEL_NAMES[loglevel]);
+  vfprintf(stderr, format, arguments);
+  fprintf(stderr, "\n");
+  va_end(arguments);
+}
+
+bool CHelper_libXBMC_addon::GetSetting(const std::string& settingName, void* settingValue)
+{
+  return FakeKodi::GetInstance().GetSetting(settingName, settingValue);
+}
+
+char* CHelper_libXBMC_addon::UnknownToUTF8(const char* str)
+{
+  // Test data is expected to be UTF-8 already, Kodi returns a copy the caller frees
+  return strdup(str);
+}
+
+void CHelper_libXBMC_addon::FreeString(char* str)
+{
+  free(str);
+}
+
+void* CHelper_libXBMC_addon::OpenFile(const char* strFileName, unsigned int flags)
+{
+  bool isRemote;
+  const std::string path = FakeKodi::GetInstance().ResolvePath(strFileName, isRemote);
+  if (path.empty())
+    return nullptr;
+
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return nullptr;
+
+  return new FakeFile{file, isRemote, false};
+}
+
+void* CHelper_libXBMC_addon::OpenFileForWrite(const char* strFileName, bool bOverWrite)
+{
+  bool isRemote;
+  const std::string path = FakeKodi::GetInstance().ResolvePath(strFileName, isRemote);
+  if (path.empty() || isRemote)
+    return nullptr;
+
+  FILE* file = fopen(path.c_str(), bOverWrite ? "wb" : "ab");
+  if (!file)
+    return nullptr;
+
+  return new FakeFile{file, false, true};
+}
+
+ssize_t CHelper_libXBMC_addon::ReadFile(void* file, void* lpBuf, size_t uiBufSize)
+{
+  FakeFile* fakeFile = static_cast<FakeFile*>(file);
+  if (!fakeFile->isRemote)
+    return fread(lpBuf, 1, uiBufSize, fakeFile->file);
+
+  const VfsOptions& vfsOptions = FakeKodi::GetInstance().GetVfsOptions();
+  if (!fakeFile->connected)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(vfsOptions.latencyMs));
+    fakeFile->connected = true;
+  }
+
+  const size_t bytesRead = fread(lpBuf, 1, std::min(uiBufSize, REMOTE_READ_CHUNK_SIZE), fakeFile->file);
+  if (vfsOptions.kilobytesPerSec > 0)
+    std::this_thread::sleep_for(std::chrono::microseconds(bytesRead * 1000000 / (vfsOptions.kilobytesPerSec * 1024)));
+
+  return bytesRead;
+}
+
+ssize_t CHelper_libXBMC_addon::WriteFile(void* file, const void* lpBuf, size_t uiBufSize)
+{
+  return fwrite(lpBuf, 1, uiBufSize, static_cast<FakeFile*>(file)->file);
+}
+
+void CHelper_libXBMC_addon::CloseFile(void* file)
+{
+  FakeFile* fakeFile = static_cast<FakeFile*>(file);
+  fclose(fakeFile->file);
+  delete fakeFile;
+}
+
+bool CHelper_libXBMC_addon::FileExists(const char* strFileName, bool bUseCache)
+{
+  struct __stat64 buffer;
+  return StatFile(strFileName, &buffer) == 0;
+}
+
+int CHelper_libXBMC_addon::StatFile(const char* strFileName, struct __stat64* buffer)
+{
+  bool isRemote;
+  const std::string path = FakeKodi::GetInstance().ResolvePath(strFileName, isRemote);
+  if (path.empty())
+    return -1;
+
+  struct stat fileStat;
+  if (stat(path.c_str(), &fileStat) != 0)
+    return -1;
+
+  memset(buffer, 0, sizeof(*buffer));
+  buffer->st_size = fileStat.st_size;
+  buffer->st_mtime = fileStat.st_mtime;
+  return 0;
+}
+
+bool CHelper_libXBMC_addon::DeleteFile(const char* strFileName)
+{
+  return remove(strFileName) == 0;
+}
+
+bool CHelper_libXBMC_addon::CreateDirectory(const char* strPath)
+{
+  return mkdir(strPath, 0755) == 0;
+}
+
+bool CHelper_libXBMC_addon::DirectoryExists(const char* strPath)
+{
+  struct stat fileStat;
+  return stat(strPath, &fileStat) == 0 && S_ISDIR(fileStat.st_mode);
+}
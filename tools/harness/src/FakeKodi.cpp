@@ -0,0 +1,174 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "FakeKodi.h"
+
+#include "rapidxml/rapidxml.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace harness;
+using namespace rapidxml;
+
+namespace
+{
+
+template<typename Handler>
+void ForEachSettingNode(xml_node<>* node, const Handler& handler)
+{
+  for (xml_node<>* childNode = node->first_node(); childNode; childNode = childNode->next_sibling())
+  {
+    if (strcmp(childNode->name(), "setting") == 0)
+      handler(childNode);
+    else
+      ForEachSettingNode(childNode, handler);
+  }
+}
+
+} // unnamed namespace
+
+bool FakeKodi::LoadSettingDefinitions(const std::string& settingsXmlPath)
+{
+  std::ifstream file(settingsXmlPath, std::ios::binary);
+  if (!file)
+  {
+    fprintf(stderr, "Unable to open settings definitions '%s'\n", settingsXmlPath.c_str());
+    return false;
+  }
+
+  std::stringstream stream;
+  stream << file.rdbuf();
+  std::string data = stream.str();
+
+  xml_document<> document;
+  try
+  {
+    document.parse<0>(&data[0]);
+  }
+  catch (parse_error& error)
+  {
+    fprintf(stderr, "Unable to parse settings definitions '%s': %s\n", settingsXmlPath.c_str(), error.what());
+    return false;
+  }
+
+  ForEachSettingNode(&document, [this](xml_node<>* settingNode)
+  {
+    xml_attribute<>* idAttribute = settingNode->first_attribute("id");
+    xml_attribute<>* typeAttribute = settingNode->first_attribute("type");
+    if (!idAttribute || !typeAttribute)
+      return;
+
+    Setting setting;
+    if (strcmp(typeAttribute->value(), "integer") == 0)
+      setting.type = SettingType::INTEGER;
+    else if (strcmp(typeAttribute->value(), "boolean") == 0)
+      setting.type = SettingType::BOOLEAN;
+    else
+      setting.type = SettingType::STRING;
+
+    xml_node<>* defaultNode = settingNode->first_node("default");
+    if (defaultNode)
+      setting.value = defaultNode->value();
+
+    m_settings[idAttribute->value()] = setting;
+  });
+
+  return !m_settings.empty();
+}
+
+bool FakeKodi::SetSetting(const std::string& settingName, const std::string& value)
+{
+  auto settingPair = m_settings.find(settingName);
+  if (settingPair == m_settings.end())
+  {
+    fprintf(stderr, "Unknown setting '%s'\n", settingName.c_str());
+    return false;
+  }
+
+  settingPair->second.value = value;
+  return true;
+}
+
+bool FakeKodi::GetSetting(const std::string& settingName, void* settingValue) const
+{
+  auto settingPair = m_settings.find(settingName);
+  if (settingPair == m_settings.end())
+    return false;
+
+  const Setting& setting = settingPair->second;
+  switch (setting.type)
+  {
+    case SettingType::INTEGER:
+      *static_cast<int*>(settingValue) = std::atoi(setting.value.c_str());
+      break;
+    case SettingType::BOOLEAN:
+      *static_cast<bool*>(settingValue) = setting.value == "true";
+      break;
+    case SettingType::STRING:
+      // Kodi copies string settings into the caller's buffer, the addon uses 1024 bytes
+      strncpy(static_cast<char*>(settingValue), setting.value.c_str(), 1023);
+      static_cast<char*>(settingValue)[1023] = '\0';
+      break;
+  }
+
+  return true;
+}
+
+std::string FakeKodi::ResolvePath(const std::string& fileName, bool& isRemote) const
+{
+  const size_t schemeEnd = fileName.find("://");
+  isRemote = schemeEnd != std::string::npos;
+  if (!isRemote)
+    return fileName;
+
+  if (m_vfsOptions.httpRoot.empty())
+    return "";
+
+  // Drop the scheme, host and query, the path is looked up under the HTTP root
+  const size_t pathStart = fileName.find('/', schemeEnd + 3);
+  if (pathStart == std::string::npos)
+    return "";
+
+  const std::string path = fileName.substr(pathStart, fileName.find('?', pathStart) - pathStart);
+
+  return m_vfsOptions.httpRoot + path;
+}
+
+TransferCollector::TransferCollector()
+{
+  m_handle.callerAddress = nullptr;
+  m_handle.dataAddress = this;
+  m_handle.dataIdentifier = 0;
+}
+
+void TransferCollector::Clear()
+{
+  channels.clear();
+  channelGroups.clear();
+  channelGroupMembers.clear();
+  epgEntries = 0;
+  epgTextBytes = 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "kodi/libXBMC_addon.h"
+#include "kodi/libXBMC_pvr.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace harness
+{
+  /**
+   * How URLs are served. A URL's path is looked up under the HTTP root so a directory
+   * of files stands in for the provider, latency and bandwidth make it behave like a network.
+   */
+  struct VfsOptions
+  {
+    std::string httpRoot;
+    int latencyMs = 0;
+    int kilobytesPerSec = 0;
+  };
+
+  /**
+   * Everything Kodi would otherwise provide to the addon: settings, the VFS options and a count of triggers
+   */
+  class FakeKodi
+  {
+  public:
+    static FakeKodi& GetInstance()
+    {
+      static FakeKodi fakeKodi;
+      return fakeKodi;
+    }
+
+    /**
+     * Reads the setting types and defaults from the addon's settings.xml
+     */
+    bool LoadSettingDefinitions(const std::string& settingsXmlPath);
+    bool SetSetting(const std::string& settingName, const std::string& value);
+    bool GetSetting(const std::string& settingName, void* settingValue) const;
+
+    void SetLogLevel(ADDON::addon_log_t level) { m_logLevel = level; }
+    ADDON::addon_log_t GetLogLevel() const { return m_logLevel; }
+
+    VfsOptions& GetVfsOptions() { return m_vfsOptions; }
+    /**
+     * The local path a file name or URL is read from, empty if a URL can't be served
+     */
+    std::string ResolvePath(const std::string& fileName, bool& isRemote) const;
+
+    std::atomic_int channelUpdatesTriggered{0};
+    std::atomic_int channelGroupsUpdatesTriggered{0};
+    std::atomic_int epgUpdatesTriggered{0};
+    std::atomic_int menuHooksAdded{0};
+
+  private:
+    enum class SettingType
+    {
+      INTEGER,
+      BOOLEAN,
+      STRING
+    };
+
+    struct Setting
+    {
+      SettingType type;
+      std::string value;
+    };
+
+    FakeKodi() = default;
+
+    FakeKodi(FakeKodi const&) = delete;
+    void operator=(FakeKodi const&) = delete;
+
+    std::map<std::string, Setting> m_settings;
+    ADDON::addon_log_t m_logLevel = ADDON::LOG_NOTICE;
+    VfsOptions m_vfsOptions;
+  };
+
+  /**
+   * Collects what the addon transfers for one request, point an ADDON_HANDLE at it with GetHandle()
+   */
+  class TransferCollector
+  {
+  public:
+    TransferCollector();
+
+    ADDON_HANDLE GetHandle() { return &m_handle; }
+    void Clear();
+
+    std::vector<PVR_CHANNEL> channels;
+    std::vector<PVR_CHANNEL_GROUP> channelGroups;
+    std::vector<PVR_CHANNEL_GROUP_MEMBER> channelGroupMembers;
+    // EPG tags point at strings owned by the addon so only what they add up to is kept
+    size_t epgEntries = 0;
+    size_t epgTextBytes = 0;
+
+  private:
+    ADDON_HANDLE_STRUCT m_handle;
+  };
+} // namespace harness
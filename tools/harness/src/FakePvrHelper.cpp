@@ -0,0 +1,82 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+#include "FakeKodi.h"
+
+#include <cstring>
+
+using namespace harness;
+
+namespace
+{
+
+size_t TextLength(const char* text)
+{
+  return text ? strlen(text) : 0;
+}
+
+} // unnamed namespace
+
+void CHelper_libXBMC_pvr::TransferEpgEntry(const ADDON_HANDLE handle, const EPG_TAG* entry)
+{
+  TransferCollector* collector = static_cast<TransferCollector*>(handle->dataAddress);
+  collector->epgEntries++;
+  collector->epgTextBytes += TextLength(entry->strTitle) + TextLength(entry->strPlotOutline) + TextLength(entry->strPlot) +
+                             TextLength(entry->strCast) + TextLength(entry->strDirector) + TextLength(entry->strWriter) +
+                             TextLength(entry->strIconPath) + TextLength(entry->strGenreDescription) +
+                             TextLength(entry->strEpisodeName);
+}
+
+void CHelper_libXBMC_pvr::TransferChannelEntry(const ADDON_HANDLE handle, const PVR_CHANNEL* entry)
+{
+  static_cast<TransferCollector*>(handle->dataAddress)->channels.emplace_back(*entry);
+}
+
+void CHelper_libXBMC_pvr::TransferChannelGroup(const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP* entry)
+{
+  static_cast<TransferCollector*>(handle->dataAddress)->channelGroups.emplace_back(*entry);
+}
+
+void CHelper_libXBMC_pvr::TransferChannelGroupMember(const ADDON_HANDLE handle, const PVR_CHANNEL_GROUP_MEMBER* entry)
+{
+  static_cast<TransferCollector*>(handle->dataAddress)->channelGroupMembers.emplace_back(*entry);
+}
+
+void CHelper_libXBMC_pvr::AddMenuHook(PVR_MENUHOOK* hook)
+{
+  FakeKodi::GetInstance().menuHooksAdded++;
+}
+
+void CHelper_libXBMC_pvr::TriggerChannelUpdate()
+{
+  FakeKodi::GetInstance().channelUpdatesTriggered++;
+}
+
+void CHelper_libXBMC_pvr::TriggerChannelGroupsUpdate()
+{
+  FakeKodi::GetInstance().channelGroupsUpdatesTriggered++;
+}
+
+void CHelper_libXBMC_pvr::TriggerEpgUpdate(unsigned int iChannelUid)
+{
+  FakeKodi::GetInstance().epgUpdatesTriggered++;
+}
@@ -0,0 +1,293 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * Drives the addon the way Kodi does at startup: ADDON_Create, wait for the playlist
+ * and EPG to load, then fetch the channels, groups, stream properties and EPG and
+ * ADDON_Destroy, timing each step. Everything Kodi would provide is faked in process.
+ */
+
+#include "FakeKodi.h"
+
+#include "PVRIptvData.h"
+#include "iptvsimple/Settings.h"
+#include "kodi/xbmc_pvr_dll.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+using namespace harness;
+using namespace iptvsimple;
+
+extern PVRIptvData* m_data;
+
+namespace
+{
+
+struct HarnessOptions
+{
+  std::string userPath = "harness-userdata";
+  std::string addonPath = HARNESS_ADDON_PATH;
+  std::vector<std::pair<std::string, std::string>> settings;
+  bool warm = false;
+  int epgDays = 3;
+  int timeoutSecs = 600;
+  ADDON::addon_log_t logLevel = ADDON::LOG_NOTICE;
+};
+
+class StepTimer
+{
+public:
+  StepTimer(const char* name) : m_name(name), m_start(std::chrono::steady_clock::now()) {}
+  ~StepTimer()
+  {
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - m_start;
+    printf("%-32s %10.1f ms\n", m_name, elapsed.count());
+  }
+
+private:
+  const char* m_name;
+  std::chrono::steady_clock::time_point m_start;
+};
+
+void PrintUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --help                    Show this help\n"
+          "  --m3u <path|url>          Playlist, a URL is served from the HTTP root\n"
+          "  --xmltv <path|url>        XMLTV, a URL is served from the HTTP root\n"
+          "  --setting <id>=<value>    Any other addon setting, can be repeated\n"
+          "  --http-root <dir>         Directory URLs are read from\n"
+          "  --http-latency-ms <ms>    Delay before the first byte of each URL\n"
+          "  --http-kbps <KB/s>        Bandwidth URLs are read at, 0 for unlimited\n"
+          "  --user-path <dir>         Addon user data directory, default harness-userdata\n"
+          "  --addon-path <dir>        Addon directory holding resources/settings.xml\n"
+          "  --warm                    Keep the caches and playlist snapshot from the last run\n"
+          "  --epg-days <days>         Days of EPG to request per channel, default 3\n"
+          "  --timeout-secs <secs>     How long to wait for the startup load, default 600\n"
+          "  --log-level <0-4>         Lowest addon log level shown, 0 is debug, default 2\n",
+          program);
+}
+
+bool ParseOptions(int argc, char* argv[], HarnessOptions& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string option = argv[i];
+    if (option == "--help")
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+    else if (option == "--warm")
+    {
+      options.warm = true;
+      continue;
+    }
+
+    if (i + 1 >= argc)
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+    const std::string value = argv[++i];
+
+    if (option == "--m3u" || option == "--xmltv")
+    {
+      // Path type 0 is a local path and 1 a remote path in both settings
+      const std::string prefix = option == "--m3u" ? "m3u" : "epg";
+      const bool isRemote = value.find("://") != std::string::npos;
+      options.settings.emplace_back(prefix + "PathType", isRemote ? "1" : "0");
+      options.settings.emplace_back(prefix + (isRemote ? "Url" : "Path"), value);
+    }
+    else if (option == "--setting")
+    {
+      const size_t separator = value.find('=');
+      if (separator == std::string::npos)
+      {
+        PrintUsage(argv[0]);
+        return false;
+      }
+      options.settings.emplace_back(value.substr(0, separator), value.substr(separator + 1));
+    }
+    else if (option == "--http-root")
+      FakeKodi::GetInstance().GetVfsOptions().httpRoot = value;
+    else if (option == "--http-latency-ms")
+      FakeKodi::GetInstance().GetVfsOptions().latencyMs = std::atoi(value.c_str());
+    else if (option == "--http-kbps")
+      FakeKodi::GetInstance().GetVfsOptions().kilobytesPerSec = std::atoi(value.c_str());
+    else if (option == "--user-path")
+      options.userPath = value;
+    else if (option == "--addon-path")
+      options.addonPath = value;
+    else if (option == "--epg-days")
+      options.epgDays = std::atoi(value.c_str());
+    else if (option == "--timeout-secs")
+      options.timeoutSecs = std::atoi(value.c_str());
+    else if (option == "--log-level")
+      options.logLevel = static_cast<ADDON::addon_log_t>(std::atoi(value.c_str()));
+    else
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool WaitForStartupLoad(int timeoutSecs)
+{
+  const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSecs);
+  while (!m_data->IsStartupLoadComplete())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+  HarnessOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return EXIT_FAILURE;
+
+  FakeKodi& fakeKodi = FakeKodi::GetInstance();
+  fakeKodi.SetLogLevel(options.logLevel);
+
+  if (!fakeKodi.LoadSettingDefinitions(options.addonPath + "/resources/settings.xml"))
+    return EXIT_FAILURE;
+
+  for (const auto& setting : options.settings)
+  {
+    if (!fakeKodi.SetSetting(setting.first, setting.second))
+      return EXIT_FAILURE;
+  }
+
+  mkdir(options.userPath.c_str(), 0755);
+  if (!options.warm)
+  {
+    for (const std::string& fileName : {M3U_FILE_NAME, M3U_SNAPSHOT_FILE_NAME, TVG_FILE_NAME})
+      remove((options.userPath + "/" + fileName).c_str());
+  }
+
+  PVR_PROPERTIES properties = {0};
+  properties.strUserPath = options.userPath.c_str();
+  properties.strClientPath = options.addonPath.c_str();
+  properties.iEpgMaxDays = options.epgDays;
+
+  // Kodi passes its own callback table, the fakes ignore it so any non-null handle will do
+  int addonHandle = 0;
+
+  {
+    StepTimer timer("ADDON_Create");
+    if (ADDON_Create(&addonHandle, &properties) != ADDON_STATUS_OK)
+    {
+      fprintf(stderr, "ADDON_Create failed\n");
+      return EXIT_FAILURE;
+    }
+  }
+
+  {
+    StepTimer timer("Startup load");
+    if (!WaitForStartupLoad(options.timeoutSecs))
+    {
+      fprintf(stderr, "Startup load did not complete within %d seconds\n", options.timeoutSecs);
+      ADDON_Destroy();
+      return EXIT_FAILURE;
+    }
+  }
+
+  TransferCollector channels;
+  {
+    StepTimer timer("GetChannels");
+    GetChannels(channels.GetHandle(), false);
+    GetChannels(channels.GetHandle(), true);
+  }
+
+  TransferCollector channelGroups;
+  {
+    StepTimer timer("GetChannelGroups");
+    GetChannelGroups(channelGroups.GetHandle(), false);
+    GetChannelGroups(channelGroups.GetHandle(), true);
+  }
+
+  TransferCollector channelGroupMembers;
+  {
+    StepTimer timer("GetChannelGroupMembers");
+    for (const auto& channelGroup : channelGroups.channelGroups)
+      GetChannelGroupMembers(channelGroupMembers.GetHandle(), channelGroup);
+  }
+
+  size_t streamProperties = 0;
+  {
+    StepTimer timer("GetChannelStreamProperties");
+    for (const auto& channel : channels.channels)
+    {
+      PVR_NAMED_VALUE channelProperties[PVR_STREAM_MAX_PROPERTIES];
+      unsigned int propertiesCount = PVR_STREAM_MAX_PROPERTIES;
+      if (GetChannelStreamProperties(&channel, channelProperties, &propertiesCount) == PVR_ERROR_NO_ERROR)
+        streamProperties += propertiesCount;
+    }
+  }
+
+  TransferCollector epg;
+  {
+    StepTimer timer("GetEPGForChannel");
+    const time_t now = std::time(nullptr);
+    for (const auto& channel : channels.channels)
+      GetEPGForChannel(epg.GetHandle(), channel.iUniqueId, now - 24 * 60 * 60, now + options.epgDays * 24 * 60 * 60);
+  }
+
+  {
+    StepTimer timer("ADDON_Destroy");
+    ADDON_Destroy();
+  }
+
+  printf("\n");
+  printf("%-32s %10zu\n", "Channels", channels.channels.size());
+  printf("%-32s %10zu\n", "Channel groups", channelGroups.channelGroups.size());
+  printf("%-32s %10zu\n", "Channel group members", channelGroupMembers.channelGroupMembers.size());
+  printf("%-32s %10zu\n", "Stream properties", streamProperties);
+  printf("%-32s %10zu\n", "EPG entries", epg.epgEntries);
+  printf("%-32s %10zu\n", "EPG text bytes", epg.epgTextBytes);
+  printf("%-32s %10d\n", "Channel updates triggered", fakeKodi.channelUpdatesTriggered.load());
+  printf("%-32s %10d\n", "Channel group updates triggered", fakeKodi.channelGroupsUpdatesTriggered.load());
+  printf("%-32s %10d\n", "EPG updates triggered", fakeKodi.epgUpdatesTriggered.load());
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,579 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+/*
+ * The startup and guide latency users see, for generated datasets of increasing size.
+ * Each dataset is generated once and then run in a fresh process so the peak memory
+ * is its own. A run measures ADDON_Create until GetChannels returns every channel,
+ * then Kodi opening the full guide: GetEPGForChannel for every channel over a window,
+ * then again once the window has moved on. Last the guide is moved past the window loaded
+ * at startup and then opened again from the past days, as Kodi does. Those are loaded in the
+ * background so they are measured until the entries Kodi asks for again come back.
+ */
+
+#include "FakeKodi.h"
+
+#include "CorpusGenerator.h"
+#include "PVRIptvData.h"
+#include "iptvsimple/Epg.h"
+#include "iptvsimple/Settings.h"
+#include "iptvsimple/utilities/MemoryUtils.h"
+#include "kodi/xbmc_pvr_dll.h"
+#include "p8-platform/util/util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace generator;
+using namespace harness;
+using namespace iptvsimple;
+using namespace iptvsimple::utilities;
+
+extern PVRIptvData* m_data;
+
+namespace
+{
+
+struct Dataset
+{
+  const char* name;
+  int channels;
+  int groups;
+  int xmltvChannels;
+  int days;
+};
+
+// Huge is a large provider: most channels have no EPG, the XMLTV is still over half a GB.
+// The days reach past the window loaded at startup so moving the guide beyond it finds entries.
+const Dataset DATASETS[] = {{"small", 500, 20, 500, 9},
+                            {"medium", 2000, 100, 2000, 9},
+                            {"huge", 20000, 400, 5000, 9}};
+
+const int SECONDS_IN_HOUR = 60 * 60;
+
+struct ScenarioOptions
+{
+  std::vector<std::string> datasets = {"small", "medium", "huge"};
+  std::string workPath = "scenario-data";
+  std::string addonPath = HARNESS_ADDON_PATH;
+  std::string outputFile;
+  uint32_t seed = 1;
+  int guideDays = 3;
+  int guidePastDays = 1;
+  int slideHours = 24;
+  int timeoutSecs = 1800;
+  bool reuseData = false;
+  std::string runDataset;
+};
+
+struct LatencySummary
+{
+  size_t calls = 0;
+  double totalMs = 0;
+  double p50Us = 0;
+  double p99Us = 0;
+  double maxUs = 0;
+};
+
+struct GuideRefresh
+{
+  LatencySummary guide;
+  double refreshedMs = 0;
+  size_t entries = 0;
+};
+
+void PrintUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --help                    Show this help\n"
+          "  --datasets <names>        Comma separated from small, medium and huge, default all\n"
+          "  --work-path <dir>         Where the datasets and user data go, default scenario-data\n"
+          "  --reuse-data              Use datasets generated by an earlier run if they are there\n"
+          "  --seed <number>           Seed of the generated datasets, default 1\n"
+          "  --addon-path <dir>        Addon directory holding resources/settings.xml\n"
+          "  --out <file>              Write the JSON results to a file instead of stdout\n"
+          "  --guide-days <days>       Days in the guide window, default 3\n"
+          "  --guide-past-days <days>  Past days the guide is opened from, default 1\n"
+          "  --slide-hours <hours>     How far the guide window moves on, default 24\n"
+          "  --http-latency-ms <ms>    Delay before the first byte of each URL\n"
+          "  --http-kbps <KB/s>        Bandwidth URLs are read at, 0 for unlimited\n"
+          "  --timeout-secs <secs>     How long to wait for each load, default 1800\n",
+          program);
+}
+
+bool ParseOptions(int argc, char* argv[], ScenarioOptions& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string option = argv[i];
+    if (option == "--reuse-data")
+    {
+      options.reuseData = true;
+      continue;
+    }
+    else if (option == "--help" || i + 1 >= argc)
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+
+    const std::string value = argv[++i];
+
+    if (option == "--datasets")
+    {
+      options.datasets.clear();
+      std::stringstream names(value);
+      std::string name;
+      while (std::getline(names, name, ','))
+        options.datasets.emplace_back(name);
+    }
+    else if (option == "--work-path")
+      options.workPath = value;
+    else if (option == "--seed")
+      options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    else if (option == "--addon-path")
+      options.addonPath = value;
+    else if (option == "--out")
+      options.outputFile = value;
+    else if (option == "--guide-days")
+      options.guideDays = std::atoi(value.c_str());
+    else if (option == "--guide-past-days")
+      options.guidePastDays = std::atoi(value.c_str());
+    else if (option == "--slide-hours")
+      options.slideHours = std::atoi(value.c_str());
+    else if (option == "--http-latency-ms")
+      FakeKodi::GetInstance().GetVfsOptions().latencyMs = std::atoi(value.c_str());
+    else if (option == "--http-kbps")
+      FakeKodi::GetInstance().GetVfsOptions().kilobytesPerSec = std::atoi(value.c_str());
+    else if (option == "--timeout-secs")
+      options.timeoutSecs = std::atoi(value.c_str());
+    else if (option == "--run-dataset")
+      options.runDataset = value; // Only used by the driver to start a run in a new process
+    else
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+const Dataset* FindDataset(const std::string& name)
+{
+  for (const auto& dataset : DATASETS)
+  {
+    if (name == dataset.name)
+      return &dataset;
+  }
+
+  return nullptr;
+}
+
+double GetElapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+LatencySummary Summarise(std::vector<double> latenciesUs)
+{
+  LatencySummary summary;
+  if (latenciesUs.empty())
+    return summary;
+
+  // Nearest rank percentiles
+  std::sort(latenciesUs.begin(), latenciesUs.end());
+  auto getPercentile = [&latenciesUs](double percentile)
+  {
+    const size_t rank = static_cast<size_t>(std::ceil(percentile / 100 * latenciesUs.size()));
+    return latenciesUs[std::max<size_t>(rank, 1) - 1];
+  };
+
+  summary.calls = latenciesUs.size();
+  for (double latencyUs : latenciesUs)
+    summary.totalMs += latencyUs / 1000;
+  summary.p50Us = getPercentile(50);
+  summary.p99Us = getPercentile(99);
+  summary.maxUs = latenciesUs.back();
+
+  return summary;
+}
+
+std::string ToJson(const LatencySummary& summary)
+{
+  std::ostringstream json;
+  json.precision(1);
+  json << std::fixed << "{\"calls\": " << summary.calls << ", \"total_ms\": " << summary.totalMs
+       << ", \"p50_us\": " << summary.p50Us << ", \"p99_us\": " << summary.p99Us << ", \"max_us\": " << summary.maxUs << "}";
+  return json.str();
+}
+
+std::string GetDatasetPath(const ScenarioOptions& options, const Dataset& dataset)
+{
+  return options.workPath + "/" + dataset.name;
+}
+
+bool GenerateDataset(const ScenarioOptions& options, const Dataset& dataset)
+{
+  const std::string datasetPath = GetDatasetPath(options, dataset);
+  const std::string playlistPath = datasetPath + "/playlist.m3u";
+  const std::string xmltvPath = datasetPath + "/xmltv.xml.gz";
+
+  struct stat fileStat;
+  if (options.reuseData && stat(playlistPath.c_str(), &fileStat) == 0 && stat(xmltvPath.c_str(), &fileStat) == 0)
+    return true;
+
+  mkdir(options.workPath.c_str(), 0755);
+  mkdir(datasetPath.c_str(), 0755);
+
+  PlaylistOptions playlistOptions;
+  playlistOptions.channels = dataset.channels;
+  playlistOptions.groups = dataset.groups;
+
+  XmltvOptions xmltvOptions;
+  xmltvOptions.channels = dataset.xmltvChannels;
+  xmltvOptions.days = dataset.days;
+  xmltvOptions.startTime = std::time(nullptr) / (24 * SECONDS_IN_HOUR) * (24 * SECONDS_IN_HOUR) - 24 * SECONDS_IN_HOUR;
+
+  fprintf(stderr, "Generating the %s dataset in '%s'\n", dataset.name, datasetPath.c_str());
+  const CorpusGenerator corpusGenerator(options.seed, playlistOptions);
+
+  std::ofstream playlistFile(playlistPath, std::ios::binary);
+  corpusGenerator.GeneratePlaylist([&playlistFile](const std::string& text) { playlistFile << text; });
+  playlistFile.close();
+
+  gzFile xmltvFile = gzopen(xmltvPath.c_str(), "wb");
+  if (!xmltvFile)
+    return false;
+  bool xmltvWritten = true;
+  corpusGenerator.GenerateXmltv(xmltvOptions, [&](const std::string& text)
+  {
+    xmltvWritten &= gzwrite(xmltvFile, text.data(), static_cast<unsigned int>(text.size())) == static_cast<int>(text.size());
+  });
+  xmltvWritten &= gzclose(xmltvFile) == Z_OK;
+
+  if (!playlistFile || !xmltvWritten)
+  {
+    fprintf(stderr, "Unable to write the %s dataset\n", dataset.name);
+    return false;
+  }
+
+  return true;
+}
+
+bool RunDatasetInNewProcess(std::vector<std::string> arguments, const std::string& datasetName, std::string& output)
+{
+  arguments.emplace_back("--run-dataset");
+  arguments.emplace_back(datasetName);
+
+  std::vector<char*> argv;
+  for (auto& argument : arguments)
+    argv.emplace_back(&argument[0]);
+  argv.emplace_back(nullptr);
+
+  int pipeFds[2];
+  if (pipe(pipeFds) != 0)
+    return false;
+
+  const pid_t pid = fork();
+  if (pid < 0)
+    return false;
+
+  if (pid == 0)
+  {
+    dup2(pipeFds[1], STDOUT_FILENO);
+    close(pipeFds[0]);
+    close(pipeFds[1]);
+    // /proc/self/exe also works when the program was found on the PATH
+    execv(access("/proc/self/exe", X_OK) == 0 ? "/proc/self/exe" : argv[0], argv.data());
+    _exit(127);
+  }
+
+  close(pipeFds[1]);
+  char buffer[4096];
+  ssize_t bytesRead;
+  while ((bytesRead = read(pipeFds[0], buffer, sizeof(buffer))) > 0)
+    output.append(buffer, bytesRead);
+  close(pipeFds[0]);
+
+  int status;
+  waitpid(pid, &status, 0);
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 && !output.empty();
+}
+
+template<typename Condition>
+bool WaitFor(const Condition& condition, int timeoutSecs)
+{
+  const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSecs);
+  while (!condition())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+LatencySummary OpenGuide(const std::vector<PVR_CHANNEL>& channels, time_t start, time_t end, size_t& epgEntries)
+{
+  TransferCollector epg;
+  std::vector<double> latenciesUs;
+  latenciesUs.reserve(channels.size());
+
+  for (const auto& channel : channels)
+  {
+    const std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
+    GetEPGForChannel(epg.GetHandle(), channel.iUniqueId, start, end);
+    latenciesUs.emplace_back(GetElapsedMs(callStart) * 1000);
+  }
+
+  epgEntries = epg.epgEntries;
+  return Summarise(latenciesUs);
+}
+
+// A window that isn't loaded yet is loaded in the background and Kodi gets what is already loaded.
+// Once it is loaded the addon triggers an EPG update and Kodi asks for every channel again.
+bool OpenGuideUntilRefreshed(const std::vector<PVR_CHANNEL>& channels, time_t start, time_t end, int timeoutSecs,
+                             GuideRefresh& refresh)
+{
+  const FakeKodi& fakeKodi = FakeKodi::GetInstance();
+  const int epgUpdatesTriggered = fakeKodi.epgUpdatesTriggered;
+
+  const std::chrono::steady_clock::time_point openStart = std::chrono::steady_clock::now();
+  size_t loadedEntries;
+  refresh.guide = OpenGuide(channels, start, end, loadedEntries);
+
+  // The new EPG is in place before the first update is triggered
+  if (!WaitFor([&]() { return fakeKodi.epgUpdatesTriggered > epgUpdatesTriggered; }, timeoutSecs))
+    return false;
+
+  OpenGuide(channels, start, end, refresh.entries);
+  refresh.refreshedMs = GetElapsedMs(openStart);
+
+  return true;
+}
+
+int RunDataset(const ScenarioOptions& options, const Dataset& dataset)
+{
+  const std::string datasetPath = GetDatasetPath(options, dataset);
+  const std::string userPath = datasetPath + "/userdata";
+
+  FakeKodi& fakeKodi = FakeKodi::GetInstance();
+  fakeKodi.SetLogLevel(ADDON::LOG_ERROR);
+  fakeKodi.GetVfsOptions().httpRoot = datasetPath;
+  if (!fakeKodi.LoadSettingDefinitions(options.addonPath + "/resources/settings.xml") ||
+      !fakeKodi.SetSetting("m3uPathType", "1") || !fakeKodi.SetSetting("m3uUrl", "http://provider.example/playlist.m3u") ||
+      !fakeKodi.SetSetting("epgPathType", "1") || !fakeKodi.SetSetting("epgUrl", "http://provider.example/xmltv.xml.gz"))
+    return EXIT_FAILURE;
+
+  // Always a cold start, as after installing the addon or changing the provider
+  mkdir(userPath.c_str(), 0755);
+  for (const std::string& fileName : {M3U_FILE_NAME, M3U_SNAPSHOT_FILE_NAME, TVG_FILE_NAME})
+    remove((userPath + "/" + fileName).c_str());
+
+  PVR_PROPERTIES properties = {0};
+  properties.strUserPath = userPath.c_str();
+  properties.strClientPath = options.addonPath.c_str();
+  properties.iEpgMaxDays = options.guideDays;
+  int addonHandle = 0;
+
+  const std::chrono::steady_clock::time_point createStart = std::chrono::steady_clock::now();
+  if (ADDON_Create(&addonHandle, &properties) != ADDON_STATUS_OK)
+  {
+    fprintf(stderr, "ADDON_Create failed\n");
+    return EXIT_FAILURE;
+  }
+  const double createMs = GetElapsedMs(createStart);
+
+  // Kodi asks for the channels each time the addon triggers a channel update, it is done once all of them are returned
+  TransferCollector channels;
+  int channelUpdatesSeen = -1;
+  double firstChannelsMs = 0;
+  const bool allChannelsReturned = WaitFor([&]()
+  {
+    const int channelUpdatesTriggered = fakeKodi.channelUpdatesTriggered;
+    if (channelUpdatesTriggered == channelUpdatesSeen)
+      return false;
+
+    channelUpdatesSeen = channelUpdatesTriggered;
+    channels.Clear();
+    GetChannels(channels.GetHandle(), false);
+    GetChannels(channels.GetHandle(), true);
+
+    if (firstChannelsMs == 0 && !channels.channels.empty())
+      firstChannelsMs = GetElapsedMs(createStart);
+
+    return channels.channels.size() >= static_cast<size_t>(dataset.channels);
+  }, options.timeoutSecs);
+  const double allChannelsMs = GetElapsedMs(createStart);
+
+  const bool startupLoadComplete = WaitFor([]() { return m_data->IsStartupLoadComplete(); }, options.timeoutSecs);
+  const double startupLoadMs = GetElapsedMs(createStart);
+
+  if (!allChannelsReturned || !startupLoadComplete)
+  {
+    fprintf(stderr, "The %s dataset did not load within %d seconds, %zu channels returned\n", dataset.name,
+            options.timeoutSecs, channels.channels.size());
+    ADDON_Destroy();
+    return EXIT_FAILURE;
+  }
+
+  const time_t now = std::time(nullptr);
+  const time_t guideEnd = now + options.guideDays * 24 * SECONDS_IN_HOUR;
+  const time_t slide = options.slideHours * SECONDS_IN_HOUR;
+  size_t guideEntries;
+  size_t slideEntries;
+  const LatencySummary guide = OpenGuide(channels.channels, now, guideEnd, guideEntries);
+  const LatencySummary guideSlide = OpenGuide(channels.channels, now + slide, guideEnd + slide, slideEntries);
+
+  // Moved on until the guide ends past the window loaded at startup, then opened again from the
+  // past days, which the window loaded for the move no longer covers
+  const time_t loadedEnd = now + EPG_DEFAULT_FUTURE_DAYS * SECONDS_IN_DAY + EPG_WINDOW_SLACK_SECS;
+  const time_t pastLoadedStart = loadedEnd - options.guideDays * SECONDS_IN_DAY + slide;
+  const time_t coldOpenStart = now - options.guidePastDays * SECONDS_IN_DAY;
+  GuideRefresh guidePastLoaded;
+  GuideRefresh guideColdOpen;
+  if (!OpenGuideUntilRefreshed(channels.channels, pastLoadedStart, loadedEnd + slide, options.timeoutSecs, guidePastLoaded) ||
+      !OpenGuideUntilRefreshed(channels.channels, coldOpenStart, guideEnd, options.timeoutSecs, guideColdOpen))
+  {
+    fprintf(stderr, "The %s dataset did not refresh the EPG within %d seconds\n", dataset.name, options.timeoutSecs);
+    ADDON_Destroy();
+    return EXIT_FAILURE;
+  }
+
+  const std::chrono::steady_clock::time_point destroyStart = std::chrono::steady_clock::now();
+  ADDON_Destroy();
+  const double destroyMs = GetElapsedMs(destroyStart);
+
+  const size_t peakRssBytes = MemoryUtils::GetPeakResidentSetSize();
+
+  fprintf(stderr, "%-8s all channels %9.1f ms, startup load %9.1f ms, guide p50/p99 %9.1f/%9.1f us, "
+                  "slide p50/p99 %9.1f/%9.1f us, past loaded %9.1f ms, cold open %9.1f ms, peak RSS %zu MB\n",
+          dataset.name, allChannelsMs, startupLoadMs, guide.p50Us, guide.p99Us, guideSlide.p50Us, guideSlide.p99Us,
+          guidePastLoaded.refreshedMs, guideColdOpen.refreshedMs, peakRssBytes / (1024 * 1024));
+
+  std::ostringstream json;
+  json.precision(1);
+  json << std::fixed;
+  json << "    {\"dataset\": \"" << dataset.name << "\", \"channels\": " << dataset.channels
+       << ", \"xmltv_channels\": " << dataset.xmltvChannels << ", \"days\": " << dataset.days << ",\n";
+  json << "     \"create_ms\": " << createMs << ", \"first_channels_ms\": " << firstChannelsMs
+       << ", \"all_channels_ms\": " << allChannelsMs << ", \"startup_load_ms\": " << startupLoadMs << ",\n";
+  json << "     \"guide\": " << ToJson(guide) << ", \"guide_entries\": " << guideEntries << ",\n";
+  json << "     \"guide_slide\": " << ToJson(guideSlide) << ", \"guide_slide_entries\": " << slideEntries << ",\n";
+  json << "     \"guide_past_loaded\": " << ToJson(guidePastLoaded.guide) << ", \"guide_past_loaded_refreshed_ms\": "
+       << guidePastLoaded.refreshedMs << ", \"guide_past_loaded_entries\": " << guidePastLoaded.entries << ",\n";
+  json << "     \"guide_cold_open\": " << ToJson(guideColdOpen.guide) << ", \"guide_cold_open_refreshed_ms\": "
+       << guideColdOpen.refreshedMs << ", \"guide_cold_open_entries\": " << guideColdOpen.entries << ",\n";
+  json << "     \"destroy_ms\": " << destroyMs << ", \"peak_rss_bytes\": " << peakRssBytes << "}";
+
+  printf("%s", json.str().c_str());
+
+  return EXIT_SUCCESS;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+  ScenarioOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return EXIT_FAILURE;
+
+  if (!options.runDataset.empty())
+  {
+    const Dataset* dataset = FindDataset(options.runDataset);
+    return dataset ? RunDataset(options, *dataset) : EXIT_FAILURE;
+  }
+
+  const std::vector<std::string> arguments(argv, argv + argc);
+  std::vector<std::string> results;
+
+  for (const std::string& datasetName : options.datasets)
+  {
+    const Dataset* dataset = FindDataset(datasetName);
+    if (!dataset)
+    {
+      fprintf(stderr, "Unknown dataset '%s'\n", datasetName.c_str());
+      return EXIT_FAILURE;
+    }
+
+    std::string result;
+    if (!GenerateDataset(options, *dataset) || !RunDatasetInNewProcess(arguments, datasetName, result))
+    {
+      fprintf(stderr, "The %s dataset failed\n", datasetName.c_str());
+      return EXIT_FAILURE;
+    }
+
+    results.emplace_back(result);
+  }
+
+  char date[32];
+  const time_t now = std::time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  std::ostringstream json;
+  json << "{\n  \"context\": {\"date\": \"" << date << "\", \"version\": \"" << STR(IPTV_VERSION) << "\", \"seed\": "
+       << options.seed << ", \"guide_days\": " << options.guideDays
+       << ", \"guide_past_days\": " << options.guidePastDays << ", \"slide_hours\": " << options.slideHours << "},\n";
+  json << "  \"datasets\": [\n";
+  for (size_t i = 0; i < results.size(); i++)
+    json << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+  json << "  ]\n}\n";
+
+  if (options.outputFile.empty())
+  {
+    printf("%s", json.str().c_str());
+  }
+  else
+  {
+    std::ofstream file(options.outputFile);
+    file << json.str();
+    if (!file)
+    {
+      fprintf(stderr, "Unable to write '%s'\n", options.outputFile.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,640 @@
+/*
+ *      Copyright (C) 2005-2019 Team XBMC
+ *      http://xbmc.org
+ *
+ *  This Program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2, or (at your option)
+ *  any later version.
+ *
+ *  This Program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with XBMC; see the file COPYING.  If not, write to
+ *  the Free Software Foundation, 51 Franklin Street, Fifth Floor, Boston,
+ *  MA 02110-1335, USA.
+ *  http://www.gnu.org/copyleft/gpl.html
+ *
+ */
+
+
+/*
+ * How the calls Kodi makes from its own threads hold up against each other and against
+ * reloads. Threads call GetEPGForChannel, GetChannelStreamProperties, GetChannelGroupMembers
+ * and ADDON_SetSetting as fast as they can for a while, as the guide, the player, the channel
+ * manager and the settings dialog would, while the playlist and EPG are reloaded every few
+ * seconds. Reports the throughput and tail latency of each call and the time spent waiting
+ * for the addon's lock.
+ */
+
+#include "FakeKodi.h"
+
+#include "CorpusGenerator.h"
+#include "PVRIptvData.h"
+#include "iptvsimple/Settings.h"
+#include "iptvsimple/utilities/MemoryUtils.h"
+#include "iptvsimple/utilities/Metrics.h"
+#include "kodi/xbmc_pvr_dll.h"
+#include "p8-platform/util/util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <zlib.h>
+
+using namespace generator;
+using namespace harness;
+using namespace iptvsimple;
+using namespace iptvsimple::utilities;
+
+extern PVRIptvData* m_data;
+
+namespace
+{
+
+const int SECONDS_IN_HOUR = 60 * 60;
+
+const std::string PLAYLIST_URL = "http://provider.example/playlist.m3u";
+const std::string XMLTV_URL = "http://provider.example/xmltv.xml.gz";
+// The fake VFS ignores the query so this is the same file, but a changed setting to the addon
+const std::string RELOAD_QUERY = "?reload=1";
+
+enum class StressCall
+  : int
+{
+  GET_EPG_FOR_CHANNEL = 0,
+  GET_CHANNEL_STREAM_PROPERTIES,
+  GET_CHANNEL_GROUP_MEMBERS,
+  SET_SETTING,
+  COUNT // not a call, the number of calls
+};
+
+const char* STRESS_CALL_NAMES[] = {"GetEPGForChannel", "GetChannelStreamProperties", "GetChannelGroupMembers", "ADDON_SetSetting"};
+
+struct StressOptions
+{
+  std::string workPath = "stress-data";
+  std::string addonPath = HARNESS_ADDON_PATH;
+  std::string outputFile;
+  uint32_t seed = 1;
+  int channels = 2000;
+  int groups = 100;
+  int days = 7;
+  int guideDays = 3;
+  int durationSecs = 30;
+  int threads[static_cast<int>(StressCall::COUNT)] = {4, 2, 1, 1};
+  int reloadIntervalMs = 2500;
+  int timeoutSecs = 600;
+  bool reuseData = false;
+};
+
+/**
+ * Latencies in nanoseconds, kept to within about 3% in a fixed number of buckets so each
+ * thread can record every call. Values below 64 have a bucket each, above that each power
+ * of two is split into 32 buckets.
+ */
+class LatencyHistogram
+{
+public:
+  static const int BUCKET_COUNT = 64 + 58 * 32;
+
+  LatencyHistogram() : m_buckets(BUCKET_COUNT) {}
+
+  void Record(uint64_t valueNs)
+  {
+    m_buckets[GetBucket(valueNs)]++;
+    m_count++;
+    m_max = std::max(m_max, valueNs);
+  }
+
+  void Merge(const LatencyHistogram& histogram)
+  {
+    for (int i = 0; i < BUCKET_COUNT; i++)
+      m_buckets[i] += histogram.m_buckets[i];
+    m_count += histogram.m_count;
+    m_max = std::max(m_max, histogram.m_max);
+  }
+
+  uint64_t GetCount() const { return m_count; }
+  uint64_t GetMax() const { return m_max; }
+
+  /**
+   * Nearest rank, the upper bound of the bucket holding it
+   */
+  uint64_t GetPercentile(double percentile) const
+  {
+    const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(percentile / 100 * m_count + 0.5), 1);
+    uint64_t count = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+      count += m_buckets[i];
+      if (count >= rank)
+        return std::min(GetBucketUpperBound(i), m_max);
+    }
+
+    return m_max;
+  }
+
+private:
+  static int GetBucket(uint64_t valueNs)
+  {
+    if (valueNs < 64)
+      return static_cast<int>(valueNs);
+
+    const int shift = 63 - __builtin_clzll(valueNs) - 5;
+    return 64 + (shift - 1) * 32 + static_cast<int>(valueNs >> shift) - 32;
+  }
+
+  static uint64_t GetBucketUpperBound(int bucket)
+  {
+    if (bucket < 64)
+      return bucket;
+
+    const int shift = (bucket - 64) / 32 + 1;
+    const uint64_t mantissa = (bucket - 64) % 32 + 32;
+    return ((mantissa + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> m_buckets;
+  uint64_t m_count = 0;
+  uint64_t m_max = 0;
+};
+
+struct CallResults
+{
+  LatencyHistogram latencies;
+  uint64_t errors = 0;
+};
+
+struct Fixture
+{
+  std::vector<PVR_CHANNEL> channels;
+  std::vector<PVR_CHANNEL_GROUP> channelGroups;
+  time_t guideStart;
+  time_t guideEnd;
+};
+
+void PrintUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --help                    Show this help\n"
+          "  --work-path <dir>         Where the dataset and user data go, default stress-data\n"
+          "  --reuse-data              Use a dataset generated by an earlier run if it is there\n"
+          "  --seed <number>           Seed of the generated dataset, default 1\n"
+          "  --channels <count>        Channels in the generated dataset, default 2000\n"
+          "  --groups <count>          Groups in the generated dataset, default 100\n"
+          "  --days <days>             Days of programmes in the generated dataset, default 7\n"
+          "  --addon-path <dir>        Addon directory holding resources/settings.xml\n"
+          "  --out <file>              Write the JSON results to a file instead of stdout\n"
+          "  --duration-secs <secs>    How long the calls are made for, default 30\n"
+          "  --epg-threads <count>     Threads calling GetEPGForChannel, default 4\n"
+          "  --stream-threads <count>  Threads calling GetChannelStreamProperties, default 2\n"
+          "  --group-threads <count>   Threads calling GetChannelGroupMembers, default 1\n"
+          "  --setting-threads <count> Threads calling ADDON_SetSetting, default 1\n"
+          "  --reload-interval-ms <ms> Time between forced playlist and EPG reloads, 0 for none, default 2500\n"
+          "  --guide-days <days>       Days in the window asked for by GetEPGForChannel, default 3\n"
+          "  --timeout-secs <secs>     How long to wait for the first load, default 600\n",
+          program);
+}
+
+bool ParseOptions(int argc, char* argv[], StressOptions& options)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string option = argv[i];
+    if (option == "--reuse-data")
+    {
+      options.reuseData = true;
+      continue;
+    }
+    else if (option == "--help" || i + 1 >= argc)
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+
+    const std::string value = argv[++i];
+
+    if (option == "--work-path")
+      options.workPath = value;
+    else if (option == "--seed")
+      options.seed = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    else if (option == "--channels")
+      options.channels = std::atoi(value.c_str());
+    else if (option == "--groups")
+      options.groups = std::atoi(value.c_str());
+    else if (option == "--days")
+      options.days = std::atoi(value.c_str());
+    else if (option == "--addon-path")
+      options.addonPath = value;
+    else if (option == "--out")
+      options.outputFile = value;
+    else if (option == "--duration-secs")
+      options.durationSecs = std::atoi(value.c_str());
+    else if (option == "--epg-threads")
+      options.threads[static_cast<int>(StressCall::GET_EPG_FOR_CHANNEL)] = std::atoi(value.c_str());
+    else if (option == "--stream-threads")
+      options.threads[static_cast<int>(StressCall::GET_CHANNEL_STREAM_PROPERTIES)] = std::atoi(value.c_str());
+    else if (option == "--group-threads")
+      options.threads[static_cast<int>(StressCall::GET_CHANNEL_GROUP_MEMBERS)] = std::atoi(value.c_str());
+    else if (option == "--setting-threads")
+      options.threads[static_cast<int>(StressCall::SET_SETTING)] = std::atoi(value.c_str());
+    else if (option == "--reload-interval-ms")
+      options.reloadIntervalMs = std::atoi(value.c_str());
+    else if (option == "--guide-days")
+      options.guideDays = std::atoi(value.c_str());
+    else if (option == "--timeout-secs")
+      options.timeoutSecs = std::atoi(value.c_str());
+    else
+    {
+      PrintUsage(argv[0]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool GenerateDataset(const StressOptions& options)
+{
+  const std::string playlistPath = options.workPath + "/playlist.m3u";
+  const std::string xmltvPath = options.workPath + "/xmltv.xml.gz";
+
+  struct stat fileStat;
+  if (options.reuseData && stat(playlistPath.c_str(), &fileStat) == 0 && stat(xmltvPath.c_str(), &fileStat) == 0)
+    return true;
+
+  mkdir(options.workPath.c_str(), 0755);
+
+  PlaylistOptions playlistOptions;
+  playlistOptions.channels = options.channels;
+  playlistOptions.groups = options.groups;
+
+  XmltvOptions xmltvOptions;
+  xmltvOptions.channels = options.channels;
+  xmltvOptions.days = options.days;
+  xmltvOptions.startTime = std::time(nullptr) / (24 * SECONDS_IN_HOUR) * (24 * SECONDS_IN_HOUR) - 24 * SECONDS_IN_HOUR;
+
+  fprintf(stderr, "Generating the dataset in '%s'\n", options.workPath.c_str());
+  const CorpusGenerator corpusGenerator(options.seed, playlistOptions);
+
+  std::ofstream playlistFile(playlistPath, std::ios::binary);
+  corpusGenerator.GeneratePlaylist([&playlistFile](const std::string& text) { playlistFile << text; });
+  playlistFile.close();
+
+  gzFile xmltvFile = gzopen(xmltvPath.c_str(), "wb");
+  if (!xmltvFile)
+    return false;
+  bool xmltvWritten = true;
+  corpusGenerator.GenerateXmltv(xmltvOptions, [&](const std::string& text)
+  {
+    xmltvWritten &= gzwrite(xmltvFile, text.data(), static_cast<unsigned int>(text.size())) == static_cast<int>(text.size());
+  });
+  xmltvWritten &= gzclose(xmltvFile) == Z_OK;
+
+  if (!playlistFile || !xmltvWritten)
+  {
+    fprintf(stderr, "Unable to write the dataset\n");
+    return false;
+  }
+
+  return true;
+}
+
+template<typename Condition>
+bool WaitFor(const Condition& condition, int timeoutSecs)
+{
+  const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSecs);
+  while (!condition())
+  {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  return true;
+}
+
+/**
+ * Makes one kind of call until told to stop, on channels or groups picked at random
+ */
+void RunCaller(StressCall call, const Fixture& fixture, unsigned int seed, const std::atomic_bool& stop, CallResults& results)
+{
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<size_t> pickChannel(0, fixture.channels.size() - 1);
+  std::uniform_int_distribution<size_t> pickGroup(0, fixture.channelGroups.empty() ? 0 : fixture.channelGroups.size() - 1);
+
+  FakeKodi& fakeKodi = FakeKodi::GetInstance();
+  TransferCollector collector;
+  PVR_NAMED_VALUE properties[PVR_STREAM_MAX_PROPERTIES];
+
+  // Setting a value the addon already has still goes through the lock, without scheduling a reload
+  int epgTimeShift = 0;
+  bool epgTimeShiftOverride = false;
+  int startChannelNumber = 1;
+  fakeKodi.GetSetting("epgTimeShift", &epgTimeShift);
+  fakeKodi.GetSetting("epgTSOverride", &epgTimeShiftOverride);
+  fakeKodi.GetSetting("startNum", &startChannelNumber);
+  unsigned int settingsSet = 0;
+
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    PVR_ERROR error = PVR_ERROR_NO_ERROR;
+    const std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
+
+    switch (call)
+    {
+      case StressCall::GET_EPG_FOR_CHANNEL:
+        error = GetEPGForChannel(collector.GetHandle(), fixture.channels[pickChannel(random)].iUniqueId,
+                                 fixture.guideStart, fixture.guideEnd);
+        break;
+      case StressCall::GET_CHANNEL_STREAM_PROPERTIES:
+      {
+        unsigned int propertiesCount = PVR_STREAM_MAX_PROPERTIES;
+        error = GetChannelStreamProperties(&fixture.channels[pickChannel(random)], properties, &propertiesCount);
+        break;
+      }
+      case StressCall::GET_CHANNEL_GROUP_MEMBERS:
+        error = GetChannelGroupMembers(collector.GetHandle(), fixture.channelGroups[pickGroup(random)]);
+        break;
+      case StressCall::SET_SETTING:
+      {
+        ADDON_STATUS status;
+        switch (settingsSet++ % 3)
+        {
+          case 0:
+            status = ADDON_SetSetting("epgTimeShift", &epgTimeShift);
+            break;
+          case 1:
+            status = ADDON_SetSetting("epgTSOverride", &epgTimeShiftOverride);
+            break;
+          default:
+            status = ADDON_SetSetting("startNum", &startChannelNumber);
+            break;
+        }
+        error = status == ADDON_STATUS_OK ? PVR_ERROR_NO_ERROR : PVR_ERROR_SERVER_ERROR;
+        break;
+      }
+      default:
+        break;
+    }
+
+    const std::chrono::steady_clock::duration latency = std::chrono::steady_clock::now() - callStart;
+    results.latencies.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    if (error != PVR_ERROR_NO_ERROR)
+      results.errors++;
+
+    // Only the count of what was transferred is needed, keep the memory used flat
+    collector.Clear();
+  }
+}
+
+/**
+ * Changes the playlist URL and the EPG URL in turn so each change forces a reload, as a user changing the settings would
+ */
+void RunReloader(int reloadIntervalMs, const std::atomic_bool& stop, unsigned int& reloadsRequested)
+{
+  bool playlistQuery = false;
+  bool xmltvQuery = false;
+
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    const std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + std::chrono::milliseconds(reloadIntervalMs);
+    while (!stop.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < next)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (stop.load(std::memory_order_relaxed))
+      break;
+
+    if (reloadsRequested++ % 2 == 0)
+    {
+      playlistQuery = !playlistQuery;
+      const std::string playlistUrl = PLAYLIST_URL + (playlistQuery ? RELOAD_QUERY : "");
+      ADDON_SetSetting("m3uUrl", playlistUrl.c_str());
+    }
+    else
+    {
+      xmltvQuery = !xmltvQuery;
+      const std::string xmltvUrl = XMLTV_URL + (xmltvQuery ? RELOAD_QUERY : "");
+      ADDON_SetSetting("epgUrl", xmltvUrl.c_str());
+    }
+  }
+}
+
+std::string ToJson(const CallResults& results, int threads, double elapsedSecs)
+{
+  const LatencyHistogram& latencies = results.latencies;
+
+  std::ostringstream json;
+  json.precision(1);
+  json << std::fixed << "{\"threads\": " << threads << ", \"calls\": " << latencies.GetCount() << ", \"errors\": " << results.errors
+       << ", \"calls_per_sec\": " << latencies.GetCount() / elapsedSecs << ", \"p50_us\": " << latencies.GetPercentile(50) / 1000.0
+       << ", \"p99_us\": " << latencies.GetPercentile(99) / 1000.0 << ", \"p999_us\": " << latencies.GetPercentile(99.9) / 1000.0
+       << ", \"max_us\": " << latencies.GetMax() / 1000.0 << "}";
+  return json.str();
+}
+
+std::string ToJson(const MetricHistogram& histogram)
+{
+  std::ostringstream json;
+  json.precision(1);
+  json << std::fixed << "{\"count\": " << histogram.GetCount() << ", \"total_ms\": " << histogram.GetSum() / 1000.0
+       << ", \"mean_us\": " << (histogram.GetCount() ? static_cast<double>(histogram.GetSum()) / histogram.GetCount() : 0)
+       << ", \"p50_us\": " << histogram.GetPercentile(50) << ", \"p99_us\": " << histogram.GetPercentile(99)
+       << ", \"max_us\": " << histogram.GetMax() << "}";
+  return json.str();
+}
+
+int RunStress(StressOptions& options)
+{
+  const std::string userPath = options.workPath + "/userdata";
+
+  FakeKodi& fakeKodi = FakeKodi::GetInstance();
+  fakeKodi.SetLogLevel(ADDON::LOG_ERROR);
+  fakeKodi.GetVfsOptions().httpRoot = options.workPath;
+  // The lock wait and hold times are only recorded while metrics are collected
+  if (!fakeKodi.LoadSettingDefinitions(options.addonPath + "/resources/settings.xml") ||
+      !fakeKodi.SetSetting("m3uPathType", "1") || !fakeKodi.SetSetting("m3uUrl", PLAYLIST_URL) ||
+      !fakeKodi.SetSetting("epgPathType", "1") || !fakeKodi.SetSetting("epgUrl", XMLTV_URL) ||
+      !fakeKodi.SetSetting("collectMetrics", "true"))
+    return EXIT_FAILURE;
+
+  mkdir(userPath.c_str(), 0755);
+  for (const std::string& fileName : {M3U_FILE_NAME, M3U_SNAPSHOT_FILE_NAME, TVG_FILE_NAME})
+    remove((userPath + "/" + fileName).c_str());
+
+  PVR_PROPERTIES properties = {0};
+  properties.strUserPath = userPath.c_str();
+  properties.strClientPath = options.addonPath.c_str();
+  properties.iEpgMaxDays = options.guideDays;
+  int addonHandle = 0;
+
+  if (ADDON_Create(&addonHandle, &properties) != ADDON_STATUS_OK)
+  {
+    fprintf(stderr, "ADDON_Create failed\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!WaitFor([]() { return m_data->IsStartupLoadComplete(); }, options.timeoutSecs))
+  {
+    fprintf(stderr, "The dataset did not load within %d seconds\n", options.timeoutSecs);
+    ADDON_Destroy();
+    return EXIT_FAILURE;
+  }
+
+  Fixture fixture;
+  TransferCollector collector;
+  for (bool radio : {false, true})
+  {
+    GetChannels(collector.GetHandle(), radio);
+    GetChannelGroups(collector.GetHandle(), radio);
+  }
+  fixture.channels = collector.channels;
+  fixture.channelGroups = collector.channelGroups;
+  fixture.guideStart = std::time(nullptr);
+  fixture.guideEnd = fixture.guideStart + options.guideDays * 24 * SECONDS_IN_HOUR;
+
+  if (fixture.channels.empty())
+  {
+    fprintf(stderr, "No channels were loaded\n");
+    ADDON_Destroy();
+    return EXIT_FAILURE;
+  }
+  if (fixture.channelGroups.empty())
+    options.threads[static_cast<int>(StressCall::GET_CHANNEL_GROUP_MEMBERS)] = 0;
+
+  fprintf(stderr, "Loaded %zu channels and %zu groups, calling for %d seconds\n", fixture.channels.size(),
+          fixture.channelGroups.size(), options.durationSecs);
+
+  // Only the contention while the calls are made is of interest, not the first load
+  Metrics::GetInstance().Reset();
+  std::atomic_bool stop{false};
+  std::vector<std::vector<CallResults>> results(static_cast<int>(StressCall::COUNT));
+  std::vector<std::thread> threads;
+  unsigned int reloadsRequested = 0;
+
+  // Each caller gets its own results so the threads only contend inside the addon
+  for (int call = 0; call < static_cast<int>(StressCall::COUNT); call++)
+    results[call].resize(options.threads[call]);
+
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned int seed = options.seed;
+  for (int call = 0; call < static_cast<int>(StressCall::COUNT); call++)
+  {
+    for (auto& callerResults : results[call])
+      threads.emplace_back(RunCaller, static_cast<StressCall>(call), std::cref(fixture), seed++, std::cref(stop), std::ref(callerResults));
+  }
+  if (options.reloadIntervalMs > 0)
+    threads.emplace_back(RunReloader, options.reloadIntervalMs, std::cref(stop), std::ref(reloadsRequested));
+
+  std::this_thread::sleep_for(std::chrono::seconds(options.durationSecs));
+  stop = true;
+  for (auto& thread : threads)
+    thread.join();
+  const double elapsedSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // Read before ADDON_Destroy, which takes the lock and cancels a reload in progress.
+  // A reload of an unchanged playlist triggers no channel update, the fetches show how many ran.
+  const std::string lockWaitJson = ToJson(Metrics::Get(MetricTimer::LOCK_WAIT));
+  const std::string lockHoldJson = ToJson(Metrics::Get(MetricTimer::LOCK_HOLD));
+  const uint64_t lockWaitUs = Metrics::Get(MetricTimer::LOCK_WAIT).GetSum();
+  const uint64_t downloads = Metrics::Get(MetricTimer::DOWNLOAD).GetCount();
+  const uint64_t xmltvParses = Metrics::Get(MetricTimer::XML_PARSE).GetCount();
+
+  ADDON_Destroy();
+
+  const size_t peakRssBytes = MemoryUtils::GetPeakResidentSetSize();
+
+  char date[32];
+  const time_t now = std::time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+  std::ostringstream json;
+  json.precision(1);
+  json << std::fixed;
+  json << "{\n  \"context\": {\"date\": \"" << date << "\", \"version\": \"" << STR(IPTV_VERSION) << "\", \"seed\": " << options.seed
+       << ", \"channels\": " << fixture.channels.size() << ", \"groups\": " << fixture.channelGroups.size()
+       << ", \"duration_secs\": " << elapsedSecs << ", \"reload_interval_ms\": " << options.reloadIntervalMs
+       << ", \"guide_days\": " << options.guideDays << ", \"hardware_threads\": " << std::thread::hardware_concurrency() << "},\n";
+  json << "  \"calls\": {\n";
+
+  fprintf(stderr, "%-28s %7s %10s %10s %10s %10s %10s %10s\n", "call", "threads", "calls/s", "errors", "p50 us", "p99 us",
+          "p99.9 us", "max us");
+  for (int call = 0; call < static_cast<int>(StressCall::COUNT); call++)
+  {
+    CallResults callResults;
+    for (const auto& callerResults : results[call])
+    {
+      callResults.latencies.Merge(callerResults.latencies);
+      callResults.errors += callerResults.errors;
+    }
+
+    const LatencyHistogram& latencies = callResults.latencies;
+    fprintf(stderr, "%-28s %7d %10.0f %10llu %10.1f %10.1f %10.1f %10.1f\n", STRESS_CALL_NAMES[call], options.threads[call],
+            latencies.GetCount() / elapsedSecs, static_cast<unsigned long long>(callResults.errors),
+            latencies.GetPercentile(50) / 1000.0, latencies.GetPercentile(99) / 1000.0, latencies.GetPercentile(99.9) / 1000.0,
+            latencies.GetMax() / 1000.0);
+
+    json << "    \"" << STRESS_CALL_NAMES[call] << "\": " << ToJson(callResults, options.threads[call], elapsedSecs)
+         << (call + 1 < static_cast<int>(StressCall::COUNT) ? ",\n" : "\n");
+  }
+
+  fprintf(stderr, "Waited %.1f ms in total for the lock, %u reloads requested, %llu downloads and %llu XMLTV parses, peak RSS %zu MB\n",
+          lockWaitUs / 1000.0, reloadsRequested, static_cast<unsigned long long>(downloads),
+          static_cast<unsigned long long>(xmltvParses), peakRssBytes / (1024 * 1024));
+
+  json << "  },\n";
+  json << "  \"lock_wait\": " << lockWaitJson << ",\n";
+  json << "  \"lock_hold\": " << lockHoldJson << ",\n";
+  json << "  \"reloads\": {\"requested\": " << reloadsRequested << ", \"downloads\": " << downloads
+       << ", \"xmltv_parses\": " << xmltvParses << "},\n";
+  json << "  \"peak_rss_bytes\": " << peakRssBytes << "\n}\n";
+
+  if (options.outputFile.empty())
+  {
+    printf("%s", json.str().c_str());
+  }
+  else
+  {
+    std::ofstream file(options.outputFile);
+    file << json.str();
+    if (!file)
+    {
+      fprintf(stderr, "Unable to write '%s'\n", options.outputFile.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+} // unnamed namespace
+
+int main(int argc, char* argv[])
+{
+  StressOptions options;
+  if (!ParseOptions(argc, argv, options))
+    return EXIT_FAILURE;
+
+  if (!GenerateDataset(options))
+    return EXIT_FAILURE;
+
+  return RunStress(options);
+}